@@ -1,67 +1,105 @@
 #include "CurtisReidScaling.h"
 
+#include "../FactorHiGHS/Auxiliary.h"
 #include "../FactorHiGHS/KrylovMethods.h"
+#include "parallel/HighsParallel.h"
 
-void product(const double* x, std::vector<double>& y,
-             const std::vector<int>& ptr, const std::vector<int>& rows) {
-  // Multiply by matrix E, i.e. matrix A with all entries equal to one
-  // E * x = y
-  int n = ptr.size() - 1;
-  for (int col = 0; col < n; ++col) {
-    for (int el = ptr[col]; el < ptr[col + 1]; ++el) {
-      y[rows[el]] += x[col];
-    }
-  }
+static int grainSizeCR(int dim) {
+  // Number of rows or columns assigned to each task, a few tasks per thread
+  const int tasks_per_thread = 8;
+  return std::max(1, dim / (tasks_per_thread * highs::parallel::num_threads()));
 }
 
-void product_transpose(const double* x, std::vector<double>& y,
-                       const std::vector<int>& ptr,
-                       const std::vector<int>& rows) {
-  // Multiply by matrix E^T, i.e. matrix A^T with all entries equal to one
-  // E^T * x = y
-  int n = ptr.size() - 1;
-  for (int col = 0; col < n; ++col) {
-    for (int el = ptr[col]; el < ptr[col + 1]; ++el) {
-      y[col] += x[rows[el]];
+// Pattern of the matrix stored both by columns and by rows, so that products
+// with E and E^T can be computed in parallel without scattering: each entry of
+// the result is computed by a single task.
+// The entries of each row are stored in increasing order of column, so that
+// sums over the rows are accumulated in the same order as a column-wise
+// scatter.
+struct CRpattern {
+  int m, n;
+
+  // column-wise
+  const std::vector<int>& ptr;
+  const std::vector<int>& rows;
+
+  // row-wise, with position of each entry in the column-wise storage
+  std::vector<int> row_ptr;
+  std::vector<int> cols;
+  std::vector<int> pos;
+
+  CRpattern(int m_in, int n_in, const std::vector<int>& ptr_in,
+            const std::vector<int>& rows_in)
+      : m{m_in}, n{n_in}, ptr{ptr_in}, rows{rows_in} {
+    int nz = ptr[n];
+    row_ptr.assign(m + 1, 0);
+    cols.resize(nz);
+    pos.resize(nz);
+
+    for (int el = 0; el < nz; ++el) ++row_ptr[rows[el] + 1];
+    for (int i = 0; i < m; ++i) row_ptr[i + 1] += row_ptr[i];
+
+    std::vector<int> next(row_ptr.begin(), row_ptr.end() - 1);
+    for (int col = 0; col < n; ++col) {
+      for (int el = ptr[col]; el < ptr[col + 1]; ++el) {
+        int p = next[rows[el]]++;
+        cols[p] = col;
+        pos[p] = el;
+      }
     }
   }
-}
+};
 
 // class to apply matrix
 class CRscalingMatrix : public AbstractMatrix {
   const std::vector<double>& M_;
   const std::vector<double>& N_;
-  const std::vector<int>& ptr_;
-  const std::vector<int>& rows_;
+  const CRpattern& E_;
+
+  // buffer for E^T * rho, reused at each application
+  mutable std::vector<double> ETrho_;
 
  public:
   CRscalingMatrix(const std::vector<double>& M, const std::vector<double>& N,
-                  const std::vector<int>& ptr, const std::vector<int>& rows)
-      : M_{M}, N_{N}, ptr_{ptr}, rows_{rows} {}
+                  const CRpattern& E)
+      : M_{M}, N_{N}, E_{E}, ETrho_(N.size()) {}
 
   void apply(std::vector<double>& x) const override {
-    int n = N_.size();
-    int m = M_.size();
+    const int n = N_.size();
+    const int m = M_.size();
 
     // split rhs
-    const double* rho = &x.data()[0];
-    const double* gamma = &x.data()[m];
-
-    // compute E*gamma
-    std::vector<double> Egamma(m);
-    product(gamma, Egamma, ptr_, rows_);
-
-    // compute E^T*rho
-    std::vector<double> ETrho(n);
-    product_transpose(rho, ETrho, ptr_, rows_);
-
-    // populate lhs
-
-    // 0...m-1
-    for (int i = 0; i < m; ++i) x[i] = M_[i] * rho[i] + Egamma[i];
-
-    // m...m+n-1
-    for (int j = 0; j < n; ++j) x[m + j] = ETrho[j] + N_[j] * gamma[j];
+    double* rho = &x.data()[0];
+    double* gamma = &x.data()[m];
+
+    // compute E^T*rho, by columns
+    highs::parallel::for_each(
+        0, n,
+        [&](HighsInt start, HighsInt end) {
+          for (int col = start; col < end; ++col) {
+            double sum = 0.0;
+            for (int el = E_.ptr[col]; el < E_.ptr[col + 1]; ++el)
+              sum += rho[E_.rows[el]];
+            ETrho_[col] = sum;
+          }
+        },
+        grainSizeCR(n));
+
+    // rho <- M * rho + E * gamma, by rows. gamma is not modified yet.
+    highs::parallel::for_each(
+        0, m,
+        [&](HighsInt start, HighsInt end) {
+          for (int row = start; row < end; ++row) {
+            double sum = 0.0;
+            for (int el = E_.row_ptr[row]; el < E_.row_ptr[row + 1]; ++el)
+              sum += gamma[E_.cols[el]];
+            rho[row] = M_[row] * rho[row] + sum;
+          }
+        },
+        grainSizeCR(m));
+
+    // gamma <- E^T * rho + N * gamma
+    for (int j = 0; j < n; ++j) gamma[j] = ETrho_[j] + N_[j] * gamma[j];
   }
 };
 
@@ -88,9 +126,14 @@ void CurtisReidScaling(const std::vector<int>& ptr,
   // Takes as input the CSC matrix A.
   // Computes Curtis-Reid scaling exponents for the matrix, using powers of 2.
 
+  Clock clock;
+
   int n = colexp.size();
   int m = rowexp.size();
 
+  // row-wise copy of the pattern
+  CRpattern E(m, n, ptr, rows);
+
   // rhs for CG
   std::vector<double> rhs(m + n, 0.0);
 
@@ -104,28 +147,45 @@ void CurtisReidScaling(const std::vector<int>& ptr,
   std::vector<double> row_entries(m, 0.0);
   std::vector<double> col_entries(n, 0.0);
 
-  // log A_ij
-  for (int col = 0; col < n; ++col) {
-    for (int el = ptr[col]; el < ptr[col + 1]; ++el) {
-      int row = rows[el];
-      if (val[el] != 0.0) {
-        double temp = log2(std::abs(val[el]));
-        sumlogrow[row] += temp;
-        sumlogcol[col] += temp;
-        row_entries[row] += 1.0;
-        col_entries[col] += 1.0;
-      }
-    }
-  }
+  // log A_ij, by columns and by rows
+  highs::parallel::for_each(
+      0, n,
+      [&](HighsInt start, HighsInt end) {
+        for (int col = start; col < end; ++col) {
+          for (int el = ptr[col]; el < ptr[col + 1]; ++el) {
+            if (val[el] != 0.0) {
+              sumlogcol[col] += log2(std::abs(val[el]));
+              col_entries[col] += 1.0;
+            }
+          }
+        }
+      },
+      grainSizeCR(n));
+  highs::parallel::for_each(
+      0, m,
+      [&](HighsInt start, HighsInt end) {
+        for (int row = start; row < end; ++row) {
+          for (int p = E.row_ptr[row]; p < E.row_ptr[row + 1]; ++p) {
+            int el = E.pos[p];
+            if (val[el] != 0.0) {
+              sumlogrow[row] += log2(std::abs(val[el]));
+              row_entries[row] += 1.0;
+            }
+          }
+        }
+      },
+      grainSizeCR(m));
 
   // solve linear system with CG and diagonal preconditioner
   std::vector<double> exponents(m + n);
-  CRscalingMatrix CRmat(row_entries, col_entries, ptr, rows);
+  CRscalingMatrix CRmat(row_entries, col_entries, E);
   CRscalingPrec CRprec(row_entries, col_entries);
   int cgiter = Cg(&CRmat, &CRprec, rhs, exponents, 1e-6, 1000);
-  printf("CR scaling required %d CG iterations\n", cgiter);
 
   // unpack exponents into various components
   for (int i = 0; i < m; ++i) rowexp[i] = -std::round(exponents[i]);
   for (int j = 0; j < n; ++j) colexp[j] = -std::round(exponents[m + j]);
+
+  printf("CR scaling required %d CG iterations, %.2fs\n", cgiter,
+         clock.stop());
 }
@@ -0,0 +1,108 @@
+#include "EquilibrationScaling.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+#include "Ipm_const.h"
+#include "lp_data/HConst.h"
+
+// Round the scaling factors to powers of 2 and store the exponents
+static void scaleToExponents(const std::vector<double>& rowscale,
+                             const std::vector<double>& colscale,
+                             std::vector<int>& rowexp,
+                             std::vector<int>& colexp) {
+  for (int i = 0; i < rowexp.size(); ++i)
+    rowexp[i] = std::round(std::log2(rowscale[i]));
+  for (int j = 0; j < colexp.size(); ++j)
+    colexp[j] = std::round(std::log2(colscale[j]));
+}
+
+void GeometricMeanScaling(const std::vector<int>& ptr,
+                          const std::vector<int>& rows,
+                          const std::vector<double>& val,
+                          std::vector<int>& rowexp, std::vector<int>& colexp) {
+  int n = colexp.size();
+  int m = rowexp.size();
+
+  std::vector<double> rowscale(m, 1.0);
+  std::vector<double> colscale(n, 1.0);
+  std::vector<double> rowmin(m), rowmax(m);
+
+  for (int iter = 0; iter < kGeomScalingIter; ++iter) {
+    // rows
+    std::fill(rowmin.begin(), rowmin.end(), kHighsInf);
+    std::fill(rowmax.begin(), rowmax.end(), 0.0);
+    for (int col = 0; col < n; ++col) {
+      for (int el = ptr[col]; el < ptr[col + 1]; ++el) {
+        int row = rows[el];
+        double v = std::abs(val[el]) * rowscale[row] * colscale[col];
+        if (v == 0.0) continue;
+        rowmin[row] = std::min(rowmin[row], v);
+        rowmax[row] = std::max(rowmax[row], v);
+      }
+    }
+    for (int i = 0; i < m; ++i)
+      if (rowmax[i] > 0.0) rowscale[i] /= std::sqrt(rowmin[i] * rowmax[i]);
+
+    // columns
+    for (int col = 0; col < n; ++col) {
+      double colmin = kHighsInf;
+      double colmax = 0.0;
+      for (int el = ptr[col]; el < ptr[col + 1]; ++el) {
+        double v = std::abs(val[el]) * rowscale[rows[el]] * colscale[col];
+        if (v == 0.0) continue;
+        colmin = std::min(colmin, v);
+        colmax = std::max(colmax, v);
+      }
+      if (colmax > 0.0) colscale[col] /= std::sqrt(colmin * colmax);
+    }
+  }
+
+  printf("Geometric mean scaling required %d passes\n", kGeomScalingIter);
+
+  scaleToExponents(rowscale, colscale, rowexp, colexp);
+}
+
+void RuizScaling(const std::vector<int>& ptr, const std::vector<int>& rows,
+                 const std::vector<double>& val, std::vector<int>& rowexp,
+                 std::vector<int>& colexp) {
+  int n = colexp.size();
+  int m = rowexp.size();
+
+  std::vector<double> rowscale(m, 1.0);
+  std::vector<double> colscale(n, 1.0);
+  std::vector<double> rowmax(m), colmax(n);
+
+  int iter;
+  for (iter = 0; iter < kRuizScalingIter; ++iter) {
+    // infinity norm of rows and columns of the scaled matrix
+    std::fill(rowmax.begin(), rowmax.end(), 0.0);
+    for (int col = 0; col < n; ++col) {
+      colmax[col] = 0.0;
+      for (int el = ptr[col]; el < ptr[col + 1]; ++el) {
+        int row = rows[el];
+        double v = std::abs(val[el]) * rowscale[row] * colscale[col];
+        rowmax[row] = std::max(rowmax[row], v);
+        colmax[col] = std::max(colmax[col], v);
+      }
+    }
+
+    // check if all norms are close to one, ignoring empty rows and columns
+    double dist = 0.0;
+    for (int i = 0; i < m; ++i)
+      if (rowmax[i] > 0.0) dist = std::max(dist, std::abs(1.0 - rowmax[i]));
+    for (int j = 0; j < n; ++j)
+      if (colmax[j] > 0.0) dist = std::max(dist, std::abs(1.0 - colmax[j]));
+    if (dist < kRuizScalingTol) break;
+
+    for (int i = 0; i < m; ++i)
+      if (rowmax[i] > 0.0) rowscale[i] /= std::sqrt(rowmax[i]);
+    for (int j = 0; j < n; ++j)
+      if (colmax[j] > 0.0) colscale[j] /= std::sqrt(colmax[j]);
+  }
+
+  printf("Ruiz scaling required %d passes\n", iter);
+
+  scaleToExponents(rowscale, colscale, rowexp, colexp);
+}
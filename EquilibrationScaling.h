@@ -0,0 +1,26 @@
+#ifndef EQUILIBRATION_SCALING_H
+#define EQUILIBRATION_SCALING_H
+
+#include <cmath>
+#include <vector>
+
+// Scaling of the CSC matrix A by powers of 2, alternative to Curtis-Reid.
+// As for CurtisReidScaling, the scaled matrix is
+//  2^rowexp[i] * A_ij * 2^colexp[j].
+
+// Iterated geometric mean: each row, and then each column, is divided by the
+// geometric mean of its largest and smallest entry, for kGeomScalingIter
+// passes.
+void GeometricMeanScaling(const std::vector<int>& ptr,
+                          const std::vector<int>& rows,
+                          const std::vector<double>& val,
+                          std::vector<int>& rowexp, std::vector<int>& colexp);
+
+// Ruiz equilibration: rows and columns are divided by the square root of
+// their infinity norm, until all norms are within kRuizScalingTol of 1 or
+// kRuizScalingIter passes are done.
+void RuizScaling(const std::vector<int>& ptr, const std::vector<int>& rows,
+                 const std::vector<double>& val, std::vector<int>& rowexp,
+                 std::vector<int>& colexp);
+
+#endif
@@ -1,139 +1,180 @@
 #include "FactorHiGHSSolver.h"
 
 #include "../FactorHiGHS/KrylovMethods.h"
+#include "parallel/HighsParallel.h"
 
-int computeLowerAThetaAT(const HighsSparseMatrix& matrix,
-                         const std::vector<double>& scaling,
-                         HighsSparseMatrix& AAT,
-                         const int max_num_nz = 100000000
-                         // Cant exceed kHighsIInf = 2,147,483,647,
-                         // otherwise start_ values may overflow. Even
-                         // 100,000,000 is probably too large, unless the
-                         // matrix is near-full, since fill-in will
-                         // overflow pointers
-);
+int grainSizeNE(int dim) {
+  // Number of columns of the normal equations assigned to each task. Use a few
+  // tasks per thread, to balance the uneven cost of the columns.
+  const int tasks_per_thread = 8;
+  return std::max(1, dim / (tasks_per_thread * highs::parallel::num_threads()));
+}
 
 FactorHiGHSSolver::FactorHiGHSSolver(const Options& options)
-    : S_((FormatType)options.format), N_(S_) {}
+    : S_((FormatType)options.format), N_(S_), refine_(options.refine) {}
 
 void FactorHiGHSSolver::clear() {
   valid_ = false;
   DataCollector::get()->append();
 }
 
-int FactorHiGHSSolver::setup(const HighsSparseMatrix& A,
-                             const Options& options) {
-  std::vector<int> ptrLower;
-  std::vector<int> rowsLower;
-
-  int nA = A.num_col_;
-  int mA = A.num_row_;
-  int nzA = A.numNz();
+int FactorHiGHSSolver::setup(const HighsSparseMatrix& A, Options& options) {
+  if (options.nla == kOptionNlaChoose) return chooseNla(A, options);
 
   int negative_pivots{};
 
-  int nla_type = options.nla;
-
   // Build the matrix
-  if (nla_type == kOptionNlaAugmented) {
-    // Augmented system, lower triangular
-
-    ptrLower.resize(nA + mA + 1);
-    rowsLower.resize(nA + nzA + mA);
-
-    int next = 0;
-
-    for (int i = 0; i < nA; ++i) {
-      // diagonal element
-      rowsLower[next] = i;
-      ++next;
-
-      // column of A
-      for (int el = A.start_[i]; el < A.start_[i + 1]; ++el) {
-        rowsLower[next] = A.index_[el] + nA;
-        ++next;
-      }
-
-      ptrLower[i + 1] = next;
-    }
-
-    // 2,2 block
-    for (int i = 0; i < mA; ++i) {
-      rowsLower[next] = nA + i;
-      ++next;
-      ptrLower[nA + i + 1] = ptrLower[nA + i] + 1;
-    }
-
-    negative_pivots = nA;
-
+  if (options.nla == kOptionNlaAugmented) {
+    buildASstructure(A);
+    negative_pivots = A.num_col_;
   } else {
-    // Normal equations, full matrix
-    std::vector<double> theta;
-    HighsSparseMatrix AAt;
-    int status = computeLowerAThetaAT(A, theta, AAt);
-    if (status) {
-      printf("Failure: AAt is too large\n");
-      return kLinearSolverStatusErrorOom;
-    }
-
-    rowsLower = std::move(AAt.index_);
-    ptrLower = std::move(AAt.start_);
+    if (int status = setupNE(A, options)) return status;
   }
 
   // Perform analyse phase
-  Analyse analyse(S_, rowsLower, ptrLower, negative_pivots);
+  Analyse analyse(S_, rowsLower_, ptrLower_, negative_pivots);
   if (int status = analyse.run()) return kLinearSolverStatusErrorAnalyse;
   DataCollector::get()->printSymbolic(1);
 
   return kLinearSolverStatusOk;
 }
 
-int FactorHiGHSSolver::factorAS(const HighsSparseMatrix& A,
-                                const std::vector<double>& scaling) {
-  // only execute factorization if it has not been done yet
-  assert(!this->valid_);
-
-  // initialize
-  std::vector<int> ptrLower;
-  std::vector<int> rowsLower;
-  std::vector<double> valLower;
+void FactorHiGHSSolver::buildASstructure(const HighsSparseMatrix& A) {
+  // Augmented system, lower triangular.
+  // The values of A and of the 2,2 block are stored now, only the diagonal
+  // of the 1,1 block changes at each factorisation.
 
   int nA = A.num_col_;
   int mA = A.num_row_;
   int nzA = A.numNz();
 
-  ptrLower.resize(nA + mA + 1);
-  rowsLower.resize(nA + nzA + mA);
-  valLower.resize(nA + nzA + mA);
+  ptrLower_.assign(nA + mA + 1, 0);
+  rowsLower_.resize(nA + nzA + mA);
+  valLower_.resize(nA + nzA + mA);
 
-  // build lower triangle
   int next = 0;
 
   for (int i = 0; i < nA; ++i) {
     // diagonal element
-    rowsLower[next] = i;
-    valLower[next++] = -scaling[i];
+    rowsLower_[next] = i;
+    valLower_[next++] = 0.0;
 
     // column of A
     for (int el = A.start_[i]; el < A.start_[i + 1]; ++el) {
-      rowsLower[next] = A.index_[el] + nA;
-      valLower[next++] = A.value_[el];
+      rowsLower_[next] = A.index_[el] + nA;
+      valLower_[next++] = A.value_[el];
     }
 
-    ptrLower[i + 1] = next;
+    ptrLower_[i + 1] = next;
   }
 
   // 2,2 block
   for (int i = 0; i < mA; ++i) {
-    rowsLower[next] = nA + i;
-    valLower[next++] = 0.0;
-    ptrLower[nA + i + 1] = ptrLower[nA + i] + 1;
+    rowsLower_[next] = nA + i;
+    valLower_[next++] = 0.0;
+    ptrLower_[nA + i + 1] = ptrLower_[nA + i] + 1;
+  }
+}
+
+int FactorHiGHSSolver::setupNE(const HighsSparseMatrix& A,
+                               const Options& options) {
+  // Normal equations, full matrix
+  is_dense_.assign(A.num_col_, false);
+  if (options.dense_cols == kOptionDenseColsOn) detectDenseCols(A);
+
+  int status = buildNEstructure(A);
+  if (status) {
+    printf("Failure: AAt is too large\n");
+    return kLinearSolverStatusErrorOom;
+  }
+  return kLinearSolverStatusOk;
+}
+
+int FactorHiGHSSolver::chooseNla(const HighsSparseMatrix& A,
+                                 Options& options) {
+  // Estimated cost of an ipm iteration: one factorisation and up to
+  // 1+kMaxCorrectors solves. The efforts are weighted as in Ipm::maxCorrectors.
+  // With k dense columns, the factorisation also needs k solves with L to
+  // compute W, and each solve needs 2*k*m more operations with W.
+  auto cost = [&A](const Symbolic& S, int k) {
+    double fact_effort =
+        kFactoriseEffortWeight * (S.flops() + 100 * S.spops()) +
+        k * 2.0 * S.nz();
+    double solv_effort = 2.0 * S.nz() + 2.0 * k * A.num_row_;
+    return fact_effort + (1.0 + kMaxCorrectors) * solv_effort;
+  };
+
+  // Analyse augmented system, and keep its data aside
+  Symbolic S_as((FormatType)options.format);
+  buildASstructure(A);
+  Analyse analyse_as(S_as, rowsLower_, ptrLower_, A.num_col_);
+  bool as_ok = !analyse_as.run();
+
+  std::vector<int> ptr_as, rows_as;
+  std::vector<double> val_as;
+  ptr_as.swap(ptrLower_);
+  rows_as.swap(rowsLower_);
+  val_as.swap(valLower_);
+
+  // Analyse normal equations
+  bool ne_ok = !setupNE(A, options);
+  if (ne_ok) {
+    Analyse analyse_ne(S_, rowsLower_, ptrLower_, 0);
+    ne_ok = !analyse_ne.run();
   }
 
+  if (!as_ok && !ne_ok) return kLinearSolverStatusErrorAnalyse;
+  const int num_dense = dense_cols_.size();
+
+  // print estimates
+  printf("Augmented system : ");
+  as_ok ? printf("flops %.1e, nz %.1e, spops %.1e, cost %.1e\n", S_as.flops(),
+                 S_as.nz(), S_as.spops(), cost(S_as, 0))
+        : printf("-\n");
+  printf("Normal equations : ");
+  ne_ok ? printf("flops %.1e, nz %.1e, spops %.1e, cost %.1e\n", S_.flops(),
+                 S_.nz(), S_.spops(), cost(S_, num_dense))
+        : printf("-\n");
+
+  if (ne_ok && (!as_ok || cost(S_, num_dense) <= cost(S_as, 0))) {
+    options.nla = kOptionNlaNormEq;
+  } else {
+    options.nla = kOptionNlaAugmented;
+
+    // use the augmented system and free the normal equations
+    S_ = std::move(S_as);
+    ptrLower_.swap(ptr_as);
+    rowsLower_.swap(rows_as);
+    valLower_.swap(val_as);
+    AT_ = HighsSparseMatrix();
+    dense_cols_.clear();
+    dense_W_.clear();
+  }
+
+  printf("Choosing %s\n\n", options.nla == kOptionNlaAugmented
+                                ? "augmented system"
+                                : "normal equations");
+
+  return kLinearSolverStatusOk;
+}
+
+int FactorHiGHSSolver::factorAS(const HighsSparseMatrix& A,
+                                const std::vector<double>& scaling) {
+  // only execute factorization if it has not been done yet
+  assert(!this->valid_);
+
+  // The augmented system was built in setup, only the diagonal of the 1,1
+  // block needs to be updated. The diagonal entry of column i is the first
+  // one stored.
+  int nA = A.num_col_;
+  for (int i = 0; i < nA; ++i) valLower_[ptrLower_[i]] = -scaling[i];
+
   // factorise matrix
-  Factorise factorise(S_, rowsLower, ptrLower, valLower);
+  Factorise factorise(S_, rowsLower_, ptrLower_, valLower_);
   if (factorise.run(N_)) return kLinearSolverStatusErrorFactorise;
 
+  setRefineNorm(A, scaling, true);
+
   this->valid_ = true;
   use_as_ = true;
   return kLinearSolverStatusOk;
@@ -144,23 +185,19 @@ int FactorHiGHSSolver::factorNE(const HighsSparseMatrix& A,
   // only execute factorization if it has not been done yet
   assert(!this->valid_);
 
-  // initialize
-  std::vector<int> ptrLower;
-  std::vector<int> rowsLower;
-  std::vector<double> valLower;
-
-  int nA = A.num_col_;
-  int mA = A.num_row_;
-  int nzA = A.numNz();
-
-  // build full matrix
-  HighsSparseMatrix AAt;
-  int status = computeLowerAThetaAT(A, scaling, AAt);
+  // build full matrix, using the pattern computed in setup
+  buildNEvalues(A, scaling);
 
   // factorise
-  Factorise factorise(S_, AAt.index_, AAt.start_, AAt.value_);
+  Factorise factorise(S_, rowsLower_, ptrLower_, valLower_);
   if (factorise.run(N_)) return kLinearSolverStatusErrorFactorise;
 
+  // deal with dense columns, if any
+  if (!dense_cols_.empty() && factorDenseCols(scaling))
+    return kLinearSolverStatusErrorFactorise;
+
+  setRefineNorm(A, scaling, false);
+
   this->valid_ = true;
   use_as_ = false;
   return kLinearSolverStatusOk;
@@ -176,6 +213,9 @@ int FactorHiGHSSolver::solveNE(const std::vector<double>& rhs,
 
   N_.solve(lhs);
 
+  // correction due to dense columns, if any
+  if (!dense_cols_.empty()) solveDenseCols(lhs);
+
   return kLinearSolverStatusOk;
 }
 
@@ -187,111 +227,487 @@ int FactorHiGHSSolver::solveAS(const std::vector<double>& rhs_x,
   assert(this->valid_);
 
   int n = rhs_x.size();
+  int m = rhs_y.size();
 
-  // create single rhs
-  std::vector<double> rhs;
-  rhs.insert(rhs.end(), rhs_x.begin(), rhs_x.end());
-  rhs.insert(rhs.end(), rhs_y.begin(), rhs_y.end());
+  // copy rhs into the persistent workspace, which has the correct size after
+  // the first solve, so that no memory is allocated
+  rhs_as_.resize(n + m);
+  std::copy(rhs_x.begin(), rhs_x.end(), rhs_as_.begin());
+  std::copy(rhs_y.begin(), rhs_y.end(), rhs_as_.begin() + n);
 
-  N_.solve(rhs);
+  N_.solve(rhs_as_);
 
   // split lhs
-  lhs_x = std::vector<double>(rhs.begin(), rhs.begin() + n);
-  lhs_y = std::vector<double>(rhs.begin() + n, rhs.end());
+  lhs_x.resize(n);
+  lhs_y.resize(m);
+  std::copy(rhs_as_.begin(), rhs_as_.begin() + n, lhs_x.begin());
+  std::copy(rhs_as_.begin() + n, rhs_as_.end(), lhs_y.begin());
+
+  return kLinearSolverStatusOk;
+}
+
+// res_x = rhs_x + (scaling + Rp) * x - A^T * y
+// res_y = rhs_y - A * x
+static void residualAS(const HighsSparseMatrix& A,
+                       const std::vector<double>& scaling,
+                       const std::vector<double>& rhs_x,
+                       const std::vector<double>& rhs_y,
+                       const std::vector<double>& x,
+                       const std::vector<double>& y, std::vector<double>& res_x,
+                       std::vector<double>& res_y) {
+  res_x = rhs_x;
+  for (int i = 0; i < A.num_col_; ++i)
+    res_x[i] += (scaling[i] + kPrimalStaticRegularization) * x[i];
+  A.alphaProductPlusY(-1.0, y, res_x, true);
+  res_y = rhs_y;
+  A.alphaProductPlusY(-1.0, x, res_y);
+}
+
+// res = rhs - A * (scaling + Rp)^{-1} * A^T * y
+static void residualNE(const HighsSparseMatrix& A,
+                       const std::vector<double>& scaling,
+                       const std::vector<double>& rhs,
+                       const std::vector<double>& y, std::vector<double>& temp,
+                       std::vector<double>& res) {
+  temp.assign(A.num_col_, 0.0);
+  A.alphaProductPlusY(1.0, y, temp, true);
+  for (int i = 0; i < A.num_col_; ++i)
+    temp[i] /= scaling[i] + kPrimalStaticRegularization;
+  res = rhs;
+  A.alphaProductPlusY(-1.0, temp, res);
+}
+
+// Infinity norm of the augmented system, or of the normal equations computed
+// as the largest row sum of |A| * (scaling + Rp)^{-1} * |A|^T, which bounds
+// it from above.
+static double infNormK(const HighsSparseMatrix& A,
+                       const std::vector<double>& scaling, bool as,
+                       std::vector<double>& col_sum,
+                       std::vector<double>& row_sum) {
+  const int n = A.num_col_;
+  const int m = A.num_row_;
+  col_sum.assign(n, 0.0);
+  row_sum.assign(m, 0.0);
+  for (int col = 0; col < n; ++col) {
+    double weight = 1.0 / (scaling[col] + kPrimalStaticRegularization);
+    for (int el = A.start_[col]; el < A.start_[col + 1]; ++el)
+      col_sum[col] += std::abs(A.value_[el]);
+    if (!as) col_sum[col] *= weight;
+  }
+  double norm = 0.0;
+  for (int col = 0; col < n; ++col) {
+    for (int el = A.start_[col]; el < A.start_[col + 1]; ++el) {
+      int row = A.index_[el];
+      row_sum[row] += std::abs(A.value_[el]) * (as ? 1.0 : col_sum[col]);
+    }
+    if (as)
+      norm = std::max(norm, scaling[col] + kPrimalStaticRegularization +
+                                col_sum[col]);
+  }
+  for (int row = 0; row < m; ++row) norm = std::max(norm, row_sum[row]);
+  return norm;
+}
+
+void FactorHiGHSSolver::setRefineNorm(const HighsSparseMatrix& A,
+                                      const std::vector<double>& scaling,
+                                      bool as) {
+  // the refinement workspace is free between solves, use it for the sums
+  if (refine_ != kOptionRefineOff)
+    ref_norm_K_ = infNormK(A, scaling, as, ref_temp_, ref_res_y_);
+}
+
+int FactorHiGHSSolver::refineAS(const HighsSparseMatrix& A,
+                                const std::vector<double>& scaling,
+                                const std::vector<double>& rhs_x,
+                                const std::vector<double>& rhs_y,
+                                std::vector<double>& lhs_x,
+                                std::vector<double>& lhs_y) {
+  if (refine_ == kOptionRefineOff) return kLinearSolverStatusOk;
+
+  const double norm_rhs = infNorm(rhs_x, rhs_y);
+
+  residualAS(A, scaling, rhs_x, rhs_y, lhs_x, lhs_y, ref_res_x_, ref_res_y_);
+  double omega = infNorm(ref_res_x_, ref_res_y_) /
+                 (ref_norm_K_ * infNorm(lhs_x, lhs_y) + norm_rhs);
+
+  for (int iter = 0; iter < kMaxRefinementIter; ++iter) {
+    if (!(omega > kRefinementTolerance)) break;
+
+    // solve for the correction and apply it
+    if (int status = solveAS(ref_res_x_, ref_res_y_, ref_dx_, ref_dy_))
+      return status;
+    vectorAdd(lhs_x, ref_dx_);
+    vectorAdd(lhs_y, ref_dy_);
+
+    residualAS(A, scaling, rhs_x, rhs_y, lhs_x, lhs_y, ref_res_x_,
+               ref_res_y_);
+    double new_omega = infNorm(ref_res_x_, ref_res_y_) /
+                       (ref_norm_K_ * infNorm(lhs_x, lhs_y) + norm_rhs);
+
+    if (!(new_omega < omega)) {
+      // the correction made things worse, undo it
+      vectorAdd(lhs_x, ref_dx_, -1.0);
+      vectorAdd(lhs_y, ref_dy_, -1.0);
+      break;
+    }
+    if (new_omega > kRefinementStagnation * omega) break;
+    omega = new_omega;
+  }
+
+  return kLinearSolverStatusOk;
+}
+
+// Normal equations, to be used with Cg
+class NEMatrix : public AbstractMatrix {
+  const HighsSparseMatrix& A_;
+  const std::vector<double>& scaling_;
+  std::vector<double>& temp_;
+
+ public:
+  NEMatrix(const HighsSparseMatrix& A, const std::vector<double>& scaling,
+           std::vector<double>& temp)
+      : A_{A}, scaling_{scaling}, temp_{temp} {}
+
+  void apply(std::vector<double>& x) const override {
+    temp_.assign(A_.num_col_, 0.0);
+    A_.alphaProductPlusY(1.0, x, temp_, true);
+    for (int i = 0; i < A_.num_col_; ++i)
+      temp_[i] /= scaling_[i] + kPrimalStaticRegularization;
+    std::fill(x.begin(), x.end(), 0.0);
+    A_.alphaProductPlusY(1.0, temp_, x);
+  }
+};
+
+// Preconditioner that solves with the factorisation of the normal equations
+class NEPreconditioner : public AbstractMatrix {
+  LinearSolver& solver_;
+
+ public:
+  NEPreconditioner(LinearSolver& solver) : solver_{solver} {}
+
+  void apply(std::vector<double>& x) const override { solver_.solveNE(x, x); }
+};
+
+int FactorHiGHSSolver::refineNE(const HighsSparseMatrix& A,
+                                const std::vector<double>& scaling,
+                                const std::vector<double>& rhs,
+                                std::vector<double>& lhs) {
+  if (refine_ == kOptionRefineOff) return kLinearSolverStatusOk;
+
+  const double norm_rhs = infNorm(rhs);
+
+  residualNE(A, scaling, rhs, lhs, ref_temp_, ref_res_y_);
+  double omega =
+      infNorm(ref_res_y_) / (ref_norm_K_ * infNorm(lhs) + norm_rhs);
+
+  if (refine_ == kOptionRefineKrylov) {
+    if (!(omega > kRefinementTolerance)) return kLinearSolverStatusOk;
+
+    // preconditioned CG for the correction, starting from zero
+    ref_dy_.assign(lhs.size(), 0.0);
+    NEMatrix NEmat(A, scaling, ref_temp_);
+    NEPreconditioner NEprec(*this);
+    Cg(&NEmat, &NEprec, ref_res_y_, ref_dy_, kRefinementTolerance,
+       kMaxRefinementIter);
+    vectorAdd(lhs, ref_dy_);
+
+    // keep the correction only if it reduced the backward error
+    residualNE(A, scaling, rhs, lhs, ref_temp_, ref_res_y_);
+    double new_omega =
+        infNorm(ref_res_y_) / (ref_norm_K_ * infNorm(lhs) + norm_rhs);
+    if (!(new_omega < omega)) vectorAdd(lhs, ref_dy_, -1.0);
+
+    return kLinearSolverStatusOk;
+  }
+
+  for (int iter = 0; iter < kMaxRefinementIter; ++iter) {
+    if (!(omega > kRefinementTolerance)) break;
+
+    // solve for the correction and apply it
+    if (int status = solveNE(ref_res_y_, ref_dy_)) return status;
+    vectorAdd(lhs, ref_dy_);
+
+    residualNE(A, scaling, rhs, lhs, ref_temp_, ref_res_y_);
+    double new_omega =
+        infNorm(ref_res_y_) / (ref_norm_K_ * infNorm(lhs) + norm_rhs);
+
+    if (!(new_omega < omega)) {
+      // the correction made things worse, undo it
+      vectorAdd(lhs, ref_dy_, -1.0);
+      break;
+    }
+    if (new_omega > kRefinementStagnation * omega) break;
+    omega = new_omega;
+  }
 
   return kLinearSolverStatusOk;
 }
 
 void FactorHiGHSSolver::finalise() { DataCollector::get()->printTimes(); }
 
-int computeLowerAThetaAT(const HighsSparseMatrix& matrix,
-                         const std::vector<double>& scaling,
-                         HighsSparseMatrix& AAT, const int max_num_nz) {
-  // Create a row-wise copy of the matrix
-  HighsSparseMatrix AT = matrix;
-  AT.ensureRowwise();
-
-  int AAT_dim = matrix.num_row_;
-  AAT.num_col_ = AAT_dim;
-  AAT.num_row_ = AAT_dim;
-  AAT.start_.resize(AAT_dim + 1, 0);
-
-  std::vector<std::tuple<int, int, double>> non_zero_values;
-
-  // First pass to calculate the number of non-zero elements in each column
-  //
-  int AAT_num_nz = 0;
-  std::vector<double> AAT_col_value(AAT_dim, 0);
-  std::vector<int> AAT_col_index(AAT_dim);
-  std::vector<bool> AAT_col_in_index(AAT_dim, false);
-  for (int iRow = 0; iRow < AAT_dim; iRow++) {
-    // Go along the row of A, and then down the columns corresponding
-    // to its nonzeros
-    int num_col_el = 0;
-    for (int iRowEl = AT.start_[iRow]; iRowEl < AT.start_[iRow + 1]; iRowEl++) {
-      int iCol = AT.index_[iRowEl];
-      const double theta_value =
-          scaling.empty() ? 1.0
-                          : 1.0 / (scaling[iCol] + kPrimalStaticRegularization);
-      if (!theta_value) continue;
-      const double row_value = theta_value * AT.value_[iRowEl];
-      for (int iColEl = matrix.start_[iCol]; iColEl < matrix.start_[iCol + 1];
-           iColEl++) {
-        int iRow1 = matrix.index_[iColEl];
-        if (iRow1 < iRow) continue;
-        double term = row_value * matrix.value_[iColEl];
-        if (!AAT_col_in_index[iRow1]) {
-          // This entry is not yet in the list of possible nonzeros
-          AAT_col_in_index[iRow1] = true;
-          AAT_col_index[num_col_el++] = iRow1;
-          AAT_col_value[iRow1] = term;
-        } else {
-          // This entry is in the list of possible nonzeros
-          AAT_col_value[iRow1] += term;
+int FactorHiGHSSolver::buildNEstructure(const HighsSparseMatrix& A,
+                                        int max_num_nz) {
+  // Create a row-wise copy of the matrix, kept for the computation of the
+  // values at each iteration
+  AT_ = A;
+  AT_.ensureRowwise();
+
+  int AAT_dim = A.num_row_;
+  int num_threads = highs::parallel::num_threads();
+  int grain = grainSizeNE(AAT_dim);
+
+  ptrLower_.assign(AAT_dim + 1, 0);
+
+  // Column iRow of the lower triangle is found by going along row iRow of A,
+  // and then down the columns corresponding to its nonzeros. The candidate
+  // entries are collected in the list of the thread, which is then sorted and
+  // made unique. The list is bounded by the work needed for the column, rather
+  // than by the dimension, so its memory does not grow with m.
+  std::vector<std::vector<int>> list(num_threads);
+  auto collectColumn = [&](int iRow, std::vector<int>& col_list) {
+    col_list.clear();
+    for (int iRowEl = AT_.start_[iRow]; iRowEl < AT_.start_[iRow + 1];
+         iRowEl++) {
+      int iCol = AT_.index_[iRowEl];
+      if (is_dense_[iCol]) continue;
+      for (int iColEl = A.start_[iCol]; iColEl < A.start_[iCol + 1]; iColEl++)
+        if (A.index_[iColEl] >= iRow) col_list.push_back(A.index_[iColEl]);
+    }
+    std::sort(col_list.begin(), col_list.end());
+    col_list.erase(std::unique(col_list.begin(), col_list.end()),
+                   col_list.end());
+  };
+
+  // First pass to calculate the number of nonzeros in each column
+  highs::parallel::for_each(
+      0, AAT_dim,
+      [&](HighsInt start, HighsInt end) {
+        std::vector<int>& col_list = list[highs::parallel::thread_num()];
+        for (int iRow = start; iRow < end; ++iRow) {
+          collectColumn(iRow, col_list);
+          ptrLower_[iRow + 1] = col_list.size();
         }
+      },
+      grain);
+
+  // Prefix sum to get the column pointers. Each block of columns is summed in
+  // parallel, the sums of the blocks are accumulated serially and then added
+  // to each block in parallel.
+  int num_blocks = (AAT_dim + grain - 1) / grain;
+  std::vector<int64_t> block_sum(num_blocks + 1, 0);
+  highs::parallel::for_each(0, num_blocks, [&](HighsInt start, HighsInt end) {
+    for (int block = start; block < end; ++block) {
+      int last = std::min(AAT_dim, (block + 1) * grain);
+      for (int iRow = block * grain; iRow < last; ++iRow)
+        block_sum[block + 1] += ptrLower_[iRow + 1];
+    }
+  });
+  for (int block = 0; block < num_blocks; ++block)
+    block_sum[block + 1] += block_sum[block];
+
+  if (block_sum[num_blocks] >= max_num_nz) return kLinearSolverStatusErrorOom;
+
+  highs::parallel::for_each(0, num_blocks, [&](HighsInt start, HighsInt end) {
+    for (int block = start; block < end; ++block) {
+      int last = std::min(AAT_dim, (block + 1) * grain);
+      int64_t sum = block_sum[block];
+      for (int iRow = block * grain; iRow < last; ++iRow) {
+        sum += ptrLower_[iRow + 1];
+        ptrLower_[iRow + 1] = sum;
       }
     }
-    for (int iEl = 0; iEl < num_col_el; iEl++) {
-      int iCol = AAT_col_index[iEl];
-      assert(iCol >= iRow);
-      const double value = AAT_col_value[iCol];
-
-      non_zero_values.emplace_back(iRow, iCol, value);
-      const int num_new_nz = 1;
-      if (AAT_num_nz + num_new_nz >= max_num_nz)
-        return kLinearSolverStatusErrorOom;
-      AAT.start_[iRow + 1]++;
-      AAT_num_nz += num_new_nz;
-      AAT_col_in_index[iCol] = false;
+  });
+
+  rowsLower_.resize(ptrLower_.back());
+
+  // Second pass to fill in the indices, sorted within each column
+  highs::parallel::for_each(
+      0, AAT_dim,
+      [&](HighsInt start, HighsInt end) {
+        std::vector<int>& col_list = list[highs::parallel::thread_num()];
+        for (int iRow = start; iRow < end; ++iRow) {
+          collectColumn(iRow, col_list);
+          assert((int)col_list.size() ==
+                 ptrLower_[iRow + 1] - ptrLower_[iRow]);
+          std::copy(col_list.begin(), col_list.end(),
+                    rowsLower_.begin() + ptrLower_[iRow]);
+        }
+      },
+      grain);
+
+  valLower_.resize(rowsLower_.size());
+
+  return kLinearSolverStatusOk;
+}
+
+void FactorHiGHSSolver::buildNEvalues(const HighsSparseMatrix& A,
+                                      const std::vector<double>& scaling) {
+  // The pattern of the lower triangle of AAt, and the row-wise copy of A, were
+  // computed in setup. The rows of each column of the pattern are sorted, so
+  // each contribution is added directly to its entry of valLower_, found by
+  // binary search, and no workspace is needed. Each column is computed by a
+  // single thread, always in the same order, so the values do not depend on
+  // the number of threads.
+
+  int AAT_dim = A.num_row_;
+  highs::parallel::for_each(
+      0, AAT_dim,
+      [&](HighsInt start, HighsInt end) {
+        for (int iRow = start; iRow < end; iRow++) {
+          int* col_first = rowsLower_.data() + ptrLower_[iRow];
+          int* col_last = rowsLower_.data() + ptrLower_[iRow + 1];
+          double* col_val = valLower_.data() + ptrLower_[iRow];
+          std::fill(col_val, col_val + (col_last - col_first), 0.0);
+
+          for (int iRowEl = AT_.start_[iRow]; iRowEl < AT_.start_[iRow + 1];
+               iRowEl++) {
+            int iCol = AT_.index_[iRowEl];
+            if (is_dense_[iCol]) continue;
+            const double theta_value =
+                scaling.empty()
+                    ? 1.0
+                    : 1.0 / (scaling[iCol] + kPrimalStaticRegularization);
+            if (!theta_value) continue;
+            const double row_value = theta_value * AT_.value_[iRowEl];
+            for (int iColEl = A.start_[iCol]; iColEl < A.start_[iCol + 1];
+                 iColEl++) {
+              int iRow1 = A.index_[iColEl];
+              if (iRow1 < iRow) continue;
+              int pos =
+                  std::lower_bound(col_first, col_last, iRow1) - col_first;
+              col_val[pos] += row_value * A.value_[iColEl];
+            }
+          }
+        }
+      },
+      grainSizeNE(AAT_dim));
+}
+
+void FactorHiGHSSolver::detectDenseCols(const HighsSparseMatrix& A) {
+  int nA = A.num_col_;
+  int mA = A.num_row_;
+  if (nA == 0) return;
+
+  double average_nz = (double)A.numNz() / nA;
+  double threshold =
+      std::max(kDenseColRatio * average_nz, kDenseColFraction * mA);
+
+  // candidate dense columns
+  std::vector<std::pair<int, int>> candidates;
+  for (int col = 0; col < nA; ++col) {
+    int col_nz = A.start_[col + 1] - A.start_[col];
+    if (col_nz > threshold) candidates.push_back({col_nz, col});
+  }
+
+  // keep the densest ones, in increasing order of column index
+  std::sort(candidates.begin(), candidates.end(),
+            [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+              return a.first > b.first;
+            });
+  if (candidates.size() > kMaxDenseCols) candidates.resize(kMaxDenseCols);
+
+  dense_cols_.clear();
+  for (const auto& cand : candidates) dense_cols_.push_back(cand.second);
+  std::sort(dense_cols_.begin(), dense_cols_.end());
+
+  // store a copy of the dense columns
+  int k = dense_cols_.size();
+  dense_start_.assign(1, 0);
+  dense_index_.clear();
+  dense_value_.clear();
+  for (int col : dense_cols_) {
+    is_dense_[col] = true;
+    for (int el = A.start_[col]; el < A.start_[col + 1]; ++el) {
+      dense_index_.push_back(A.index_[el]);
+      dense_value_.push_back(A.value_[el]);
     }
+    dense_start_.push_back(dense_index_.size());
   }
 
-  // Prefix sum to get the correct column pointers
-  for (int i = 0; i < AAT_dim; ++i) AAT.start_[i + 1] += AAT.start_[i];
+  dense_W_.assign(k, std::vector<double>(mA, 0.0));
+  dense_L_.assign(k * k, 0.0);
+  dense_rhs_.assign(k, 0.0);
 
-  AAT.index_.resize(AAT.start_.back());
-  AAT.value_.resize(AAT.start_.back());
-  AAT.p_end_ = AAT.start_;
-  AAT.p_end_.back() = AAT.index_.size();
+  if (k > 0)
+    printf("Found %d dense columns, with more than %.0f nonzeros\n", k,
+           threshold);
+}
 
-  std::vector<int> current_positions = AAT.start_;
+int FactorHiGHSSolver::factorDenseCols(const std::vector<double>& scaling) {
+  int k = dense_cols_.size();
 
-  // Second pass to actually fill in the indices and values
-  for (const auto& val : non_zero_values) {
-    int i = std::get<0>(val);
-    int j = std::get<1>(val);
-    double dot = std::get<2>(val);
+  // columns of W = S^{-1} * Ad
+  for (int d = 0; d < k; ++d) {
+    std::vector<double>& w = dense_W_[d];
+    std::fill(w.begin(), w.end(), 0.0);
+    for (int el = dense_start_[d]; el < dense_start_[d + 1]; ++el)
+      w[dense_index_[el]] = dense_value_[el];
+    N_.solve(w);
+  }
+
+  // lower triangle of Schur complement Thetad^{-1} + Ad^T * W
+  for (int q = 0; q < k; ++q) {
+    for (int p = q; p < k; ++p) {
+      double val = 0.0;
+      for (int el = dense_start_[p]; el < dense_start_[p + 1]; ++el)
+        val += dense_value_[el] * dense_W_[q][dense_index_[el]];
+      dense_L_[p + q * k] = val;
+    }
+    int col = dense_cols_[q];
+    dense_L_[q + q * k] +=
+        scaling.empty() ? 1.0 : scaling[col] + kPrimalStaticRegularization;
+  }
 
-    // i>=j, so to get lower triangle, i is the col, j is row
-    AAT.index_[current_positions[i]] = j;
-    AAT.value_[current_positions[i]] = dot;
-    current_positions[i]++;
-    AAT.p_end_[i] = current_positions[i];
+  // dense Cholesky factorisation of the Schur complement
+  for (int j = 0; j < k; ++j) {
+    double pivot = dense_L_[j + j * k];
+    for (int p = 0; p < j; ++p)
+      pivot -= dense_L_[j + p * k] * dense_L_[j + p * k];
+    if (pivot <= 0.0 || !std::isfinite(pivot)) {
+      printf("Failure: Schur complement of dense columns is not positive\n");
+      return kLinearSolverStatusErrorFactorise;
+    }
+    pivot = std::sqrt(pivot);
+    dense_L_[j + j * k] = pivot;
+
+    for (int i = j + 1; i < k; ++i) {
+      double val = dense_L_[i + j * k];
+      for (int p = 0; p < j; ++p)
+        val -= dense_L_[i + p * k] * dense_L_[j + p * k];
+      dense_L_[i + j * k] = val / pivot;
+    }
   }
-  AAT.p_end_.clear();
+
   return kLinearSolverStatusOk;
 }
 
+void FactorHiGHSSolver::solveDenseCols(std::vector<double>& lhs) {
+  int k = dense_cols_.size();
+
+  // rhs = Ad^T * lhs
+  for (int p = 0; p < k; ++p) {
+    double val = 0.0;
+    for (int el = dense_start_[p]; el < dense_start_[p + 1]; ++el)
+      val += dense_value_[el] * lhs[dense_index_[el]];
+    dense_rhs_[p] = val;
+  }
+
+  // solve with L and L^T
+  for (int j = 0; j < k; ++j) {
+    dense_rhs_[j] /= dense_L_[j + j * k];
+    for (int i = j + 1; i < k; ++i)
+      dense_rhs_[i] -= dense_L_[i + j * k] * dense_rhs_[j];
+  }
+  for (int j = k - 1; j >= 0; --j) {
+    for (int i = j + 1; i < k; ++i)
+      dense_rhs_[j] -= dense_L_[i + j * k] * dense_rhs_[i];
+    dense_rhs_[j] /= dense_L_[j + j * k];
+  }
+
+  // lhs -= W * rhs
+  for (int d = 0; d < k; ++d) vectorAdd(lhs, dense_W_[d], -dense_rhs_[d]);
+}
+
 double FactorHiGHSSolver::flops() const { return S_.flops(); }
 double FactorHiGHSSolver::spops() const { return S_.spops(); }
 double FactorHiGHSSolver::nz() const { return S_.nz(); }
\ No newline at end of file
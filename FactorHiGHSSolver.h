@@ -16,6 +16,115 @@ class FactorHiGHSSolver : public LinearSolver {
   // keep track of whether as or ne is being factorized
   bool use_as_ = true;
 
+  // lower triangle of the matrix to factorise, stored in CSC format.
+  // The pattern is computed once in setup, the values at each factorisation.
+  std::vector<int> ptrLower_;
+  std::vector<int> rowsLower_;
+  std::vector<double> valLower_;
+
+  // workspace for the solution of the augmented system
+  std::vector<double> rhs_as_;
+
+  // row-wise copy of A, used to form the normal equations
+  HighsSparseMatrix AT_;
+
+  // Dense columns of A, left out of the normal equations and treated with a
+  // low-rank update:
+  // (S + Ad * Thetad * Ad^T)^{-1} =
+  //        S^{-1} - W * (Thetad^{-1} + Ad^T * W)^{-1} * W^T,   W = S^{-1} * Ad
+  // where S is the normal equations matrix of the sparse columns.
+  std::vector<int> dense_cols_;
+  std::vector<bool> is_dense_;
+  std::vector<int> dense_start_;
+  std::vector<int> dense_index_;
+  std::vector<double> dense_value_;
+
+  // columns of W
+  std::vector<std::vector<double>> dense_W_;
+
+  // Cholesky factor of the Schur complement Thetad^{-1} + Ad^T * W, stored as
+  // a full column-major matrix
+  std::vector<double> dense_L_;
+  std::vector<double> dense_rhs_;
+
+  // type of iterative refinement, and workspace used by it
+  int refine_ = kOptionRefineDefault;
+  std::vector<double> ref_res_x_;
+  std::vector<double> ref_res_y_;
+  std::vector<double> ref_dx_;
+  std::vector<double> ref_dy_;
+  std::vector<double> ref_temp_;
+
+  // infinity norm of the matrix factorised, used by the backward error of the
+  // refinement; it only changes when the matrix is factorised again
+  double ref_norm_K_{};
+
+  // ===================================================================================
+  // Compute ref_norm_K_ for the augmented system (as = true) or the normal
+  // equations with the given scaling, if refinement is used.
+  // ===================================================================================
+  void setRefineNorm(const HighsSparseMatrix& A,
+                     const std::vector<double>& scaling, bool as);
+
+  // ===================================================================================
+  // Build the lower triangle of the augmented system, with zero diagonal in
+  // the 1,1 block, and store it in ptrLower_, rowsLower_, valLower_.
+  // ===================================================================================
+  void buildASstructure(const HighsSparseMatrix& A);
+
+  // ===================================================================================
+  // Detect dense columns, if requested, and build the pattern of the normal
+  // equations.
+  // ===================================================================================
+  int setupNE(const HighsSparseMatrix& A, const Options& options);
+
+  // ===================================================================================
+  // Run the analyse phase for both the augmented system and the normal
+  // equations, report the estimates and keep the cheapest one. Upon return,
+  // options.nla is set to the method chosen.
+  // ===================================================================================
+  int chooseNla(const HighsSparseMatrix& A, Options& options);
+
+  // ===================================================================================
+  // Compute the pattern of the lower triangle of A * A^T and store it in
+  // ptrLower_, rowsLower_. Blocks of columns are processed in parallel.
+  // Fails if the number of nonzeros exceeds max_num_nz, which cannot exceed
+  // kHighsIInf = 2,147,483,647, otherwise ptrLower_ may overflow. Even
+  // 100,000,000 is probably too large, unless the matrix is near-full, since
+  // fill-in will overflow pointers.
+  // ===================================================================================
+  int buildNEstructure(const HighsSparseMatrix& A,
+                       int max_num_nz = 100000000);
+
+  // ===================================================================================
+  // Compute the values of the lower triangle of A * Theta * A^T, using the
+  // pattern computed by buildNEstructure, and store them in valLower_.
+  // Blocks of columns are processed in parallel and the result does not depend
+  // on the number of threads.
+  // ===================================================================================
+  void buildNEvalues(const HighsSparseMatrix& A,
+                     const std::vector<double>& scaling);
+
+  // ===================================================================================
+  // Find the columns of A that would make the normal equations too dense. A
+  // column is dense if it has more than kDenseColRatio times the average
+  // number of nonzeros and more than kDenseColFraction * m nonzeros. At most
+  // kMaxDenseCols of the densest columns are selected.
+  // ===================================================================================
+  void detectDenseCols(const HighsSparseMatrix& A);
+
+  // ===================================================================================
+  // After the sparse part S is factorised, compute W and factorise the Schur
+  // complement of the dense columns.
+  // ===================================================================================
+  int factorDenseCols(const std::vector<double>& scaling);
+
+  // ===================================================================================
+  // Given lhs = S^{-1} * rhs, apply the correction due to the dense columns:
+  //  lhs -= W * (Thetad^{-1} + Ad^T * W)^{-1} * Ad^T * lhs
+  // ===================================================================================
+  void solveDenseCols(std::vector<double>& lhs);
+
  public:
   FactorHiGHSSolver(const Options& options);
 
@@ -29,12 +138,40 @@ class FactorHiGHSSolver : public LinearSolver {
   int solveAS(const std::vector<double>& rhs_x,
               const std::vector<double>& rhs_y, std::vector<double>& lhs_x,
               std::vector<double>& lhs_y) override;
-  int setup(const HighsSparseMatrix& A, const Options& options) override;
+  int setup(const HighsSparseMatrix& A, Options& options) override;
+
+  // ===================================================================================
+  // Iterative refinement of a solution of the augmented system or normal
+  // equations, towards the system with matrix
+  //  AS:  [ -(Theta^{-1} + Rp)  A^T ]
+  //       [  A                  0   ]
+  //  NE:  A * (Theta^{-1} + Rp)^{-1} * A^T
+  // where Theta^{-1} is scaling and Rp is the primal static regularisation,
+  // i.e. the system that the ipm uses to recover the direction.
+  //
+  // Classic refinement solves with the factorisation for the correction. For
+  // NE, the Krylov mode runs preconditioned CG on the correction, with the
+  // factorisation as preconditioner; the augmented system is indefinite, so
+  // it always uses classic refinement.
+  //
+  // Refinement stops when the normwise backward error
+  //  ||rhs - K * lhs||_inf / (||K||_inf * ||lhs||_inf + ||rhs||_inf)
+  // is below kRefinementTolerance, when it stagnates, or after
+  // kMaxRefinementIter steps. A step that increases it is undone.
+  // ===================================================================================
+  int refineAS(const HighsSparseMatrix& A, const std::vector<double>& scaling,
+               const std::vector<double>& rhs_x,
+               const std::vector<double>& rhs_y, std::vector<double>& lhs_x,
+               std::vector<double>& lhs_y) override;
+  int refineNE(const HighsSparseMatrix& A, const std::vector<double>& scaling,
+               const std::vector<double>& rhs,
+               std::vector<double>& lhs) override;
   void clear() override;
   void finalise() override;
   double flops() const override;
   double spops() const override;
   double nz() const override;
+  int numDenseCols() const override;
 };
 
 #endif
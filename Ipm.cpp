@@ -6,23 +6,141 @@
 
 #include "parallel/HighsParallel.h"
 
+#ifdef COUNT_ALLOCATIONS
+// Count the heap allocations performed by the ipm during the iterations. The
+// linear solver is excluded, since the factorisation is allowed to allocate.
+// In steady state, i.e. after the first iteration, the count must be zero.
+#include <cstdlib>
+#include <new>
+
+static long long alloc_count = 0;
+static bool alloc_active = false;
+
+void* operator new(std::size_t size) {
+  if (alloc_active) ++alloc_count;
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+struct PauseAllocationCount {
+  bool old_active;
+  PauseAllocationCount() : old_active(alloc_active) { alloc_active = false; }
+  ~PauseAllocationCount() { alloc_active = old_active; }
+};
+
+#define START_ALLOCATION_COUNT \
+  alloc_count = 0;             \
+  alloc_active = true;
+#define STOP_ALLOCATION_COUNT                                        \
+  alloc_active = false;                                              \
+  printf("Allocations in iteration %d: %lld\n", iter_, alloc_count); \
+  assert(iter_ <= 1 || alloc_count == 0);
+#define END_ALLOCATION_COUNT alloc_active = false;
+#define PAUSE_ALLOCATION_COUNT PauseAllocationCount pause_alloc_count
+#else
+#define START_ALLOCATION_COUNT
+#define STOP_ALLOCATION_COUNT
+#define END_ALLOCATION_COUNT
+#define PAUSE_ALLOCATION_COUNT
+#endif
+
 void Ipm::load(const int num_var, const int num_con, const double* obj,
                const double* rhs, const double* lower, const double* upper,
                const int* A_ptr, const int* A_rows, const double* A_vals,
                const char* constraints, double offset,
                const std::string& pb_name, const Options& options) {
   if (!obj || !rhs || !lower || !upper || !A_ptr || !A_rows || !A_vals ||
-      !constraints)
+      !constraints || num_var < 0 || num_con < 0)
     return;
 
   model_.init(num_var, num_con, obj, rhs, lower, upper, A_ptr, A_rows, A_vals,
-              constraints, offset, pb_name);
+              constraints, offset, pb_name, options);
+
+  m_ = model_.m();
+  n_ = model_.n();
+
+  options_ = options;
+  ipx_used_ = false;
+  setup_ok_ = false;
+  warm_start_ = false;
+}
+
+void Ipm::load(const int num_var, const int num_con, std::vector<double>&& obj,
+               std::vector<double>&& rhs, std::vector<double>&& lower,
+               std::vector<double>&& upper, std::vector<int>&& A_ptr,
+               std::vector<int>&& A_rows, std::vector<double>&& A_vals,
+               std::vector<char>&& constraints, double offset,
+               const std::string& pb_name, const Options& options) {
+  // the vectors are adopted as they are, so they must have exactly the sizes
+  // of the LP, otherwise the slacks would be appended after stale entries
+  if (num_var < 0 || num_con < 0) return;
+  if (obj.size() != num_var || rhs.size() != num_con ||
+      lower.size() != num_var || upper.size() != num_var ||
+      A_ptr.size() != num_var + 1 || constraints.size() != num_con ||
+      A_ptr[num_var] < 0 || A_rows.size() != A_ptr[num_var] ||
+      A_vals.size() != A_ptr[num_var])
+    return;
+
+  model_.init(num_var, num_con, std::move(obj), std::move(rhs),
+              std::move(lower), std::move(upper), std::move(A_ptr),
+              std::move(A_rows), std::move(A_vals), std::move(constraints),
+              offset, pb_name, options);
+
+  m_ = model_.m();
+  n_ = model_.n();
+
+  options_ = options;
+  ipx_used_ = false;
+  setup_ok_ = false;
+  warm_start_ = false;
+}
+
+void Ipm::reserveForSlacks(int num_col, int num_row, int num_nz,
+                           std::vector<double>& obj,
+                           std::vector<double>& lower,
+                           std::vector<double>& upper,
+                           std::vector<int>& A_ptr, std::vector<int>& A_rows,
+                           std::vector<double>& A_vals) {
+  obj.reserve(num_col + num_row);
+  lower.reserve(num_col + num_row);
+  upper.reserve(num_col + num_row);
+  A_ptr.reserve(num_col + num_row + 1);
+  A_rows.reserve(num_nz + num_row);
+  A_vals.reserve(num_nz + num_row);
+}
+
+bool Ipm::loadSnapshot(const std::string& file_name,
+                       const Options& options) {
+  if (!model_.readSnapshot(file_name)) return false;
 
   m_ = model_.m();
   n_ = model_.n();
 
   options_ = options;
   ipx_used_ = false;
+  setup_ok_ = false;
+  warm_start_ = false;
+
+  return true;
+}
+
+bool Ipm::writeSnapshot(const std::string& file_name) const {
+  return model_.writeSnapshot(file_name);
+}
+
+void Ipm::update(const double* obj, const double* rhs, const double* lower,
+                 const double* upper) {
+  if (!model_.ready()) return;
+
+  model_.update(obj, rhs, lower, upper);
+
+  // warm start is possible only if a previous solve set up the linear solver
+  // and left a valid iterate
+  warm_start_ = setup_ok_ && it_ && ipm_status_ != kIpmStatusError &&
+                !it_->isNan() && !it_->isInf();
+  ipx_used_ = false;
 }
 
 IpmStatus Ipm::solve() {
@@ -41,16 +159,49 @@ IpmStatus Ipm::solve() {
 }
 
 void Ipm::runIpm() {
-  if (initialize()) return;
+  Clock clock;
+  stats_.clear();
+
+  if (!options_.log_file.empty()) {
+    log_.reset(new IterationLog);
+    if (!log_->open(options_.log_file, model_.name())) {
+      printf("Cannot open iteration log %s\n", options_.log_file.c_str());
+      log_.reset();
+    }
+  }
+
+  if (warm_start_ ? initializeWarm() : initialize()) {
+    log_.reset();
+    ipm_time_ = clock.stop();
+    return;
+  }
 
   while (iter_ < kMaxIterations) {
+    START_ALLOCATION_COUNT;
     if (prepareIter()) break;
     if (predictor()) break;
     if (correctors()) break;
     makeStep();
+    logIteration();
+    if (options_.correctors == kOptionCorrectorsAdaptive) adaptCorrectors();
+    STOP_ALLOCATION_COUNT;
   }
 
+  // an iteration interrupted by a break is not complete, so it is not checked
+  END_ALLOCATION_COUNT;
+
+  // write the records left and stop the writer
+  log_.reset();
+
   LS_->finalise();
+  ipm_time_ = clock.stop();
+  stats_.print();
+}
+
+int Ipm::factorise(const std::vector<double>& scaling) {
+  IPM_TIME_PHASE(stats_, kPhaseFactorise, 8.0 * LS_->nz());
+  return options_.nla == kOptionNlaNormEq ? LS_->factorNE(model_.A(), scaling)
+                                          : LS_->factorAS(model_.A(), scaling);
 }
 
 bool Ipm::initialize() {
@@ -60,19 +211,38 @@ bool Ipm::initialize() {
   // start timer
   clock_.start();
 
+  resetStatus();
+
   // initialize iterate object
   it_.reset(new IpmIterate(model_));
 
+  // allocate the workspace used during the iterations
+  work_.reset(new IpmWorkspace(m_, n_));
+  computeNormsA();
+
   // initialize linear solver
+  setup_ok_ = false;
   LS_.reset(new FactorHiGHSSolver(options_));
-  if (LS_->setup(model_.A(), options_)) {
+  int setup_status;
+  {
+    IPM_TIME_PHASE(stats_, kPhaseAnalyse, 0.0);
+    setup_status = LS_->setup(model_.A(), options_);
+  }
+  if (setup_status) {
     ipm_status_ = kIpmStatusError;
     return true;
   }
+  setup_ok_ = true;
   LS_->clear();
 
   // decide number of correctors to use
   maxCorrectors();
+  avg_factorise_time_ = 0.0;
+  avg_solve_time_ = 0.0;
+  avg_iter_time_ = 0.0;
+  avg_cor_payoff_ = 0.0;
+  avg_cor_accepted_ = 0.0;
+  num_cor_measured_ = 0;
 
   startingPoint();
 
@@ -85,6 +255,58 @@ bool Ipm::initialize() {
   return false;
 }
 
+bool Ipm::initializeWarm() {
+  // Prepare ipm for execution after the model has been updated, keeping the
+  // linear solver and the last iterate.
+  // Return true if an error occurred.
+
+  clock_.start();
+
+  resetStatus();
+
+  // rhs and bounds changed, so the norms of A are still valid, while the
+  // symbolic factorisation is reused as it is
+  LS_->clear();
+
+  warmStartingPoint();
+
+  it_->clearDir();
+  it_->clearRes();
+  it_->residual1234();
+  it_->computeMu();
+  it_->indicators();
+
+  printOutput();
+
+  return false;
+}
+
+void Ipm::resetStatus() {
+  // Counters, status and stepsizes are left over from a previous run, so they
+  // are reset before each new one, cold or warm.
+  iter_ = 0;
+  bad_iter_ = 0;
+  ipm_status_ = kIpmStatusMaxIter;
+  alpha_primal_ = 0.0;
+  alpha_dual_ = 0.0;
+}
+
+void Ipm::computeNormsA() {
+  std::vector<double> norm_cols_A(n_);
+  std::vector<double> norm_rows_A(m_);
+  for (int col = 0; col < n_; ++col) {
+    for (int el = model_.A().start_[col]; el < model_.A().start_[col + 1];
+         ++el) {
+      int row = model_.A().index_[el];
+      double val = model_.A().value_[el];
+      norm_cols_A[col] += std::abs(val);
+      norm_rows_A[row] += std::abs(val);
+    }
+  }
+  one_norm_A_ = *std::max_element(norm_cols_A.begin(), norm_cols_A.end());
+  inf_norm_A_ = *std::max_element(norm_rows_A.begin(), norm_rows_A.end());
+}
+
 bool Ipm::prepareIter() {
   // Prepare next iteration.
   // Return true if Ipm main loop should be stopped
@@ -99,10 +321,16 @@ bool Ipm::prepareIter() {
   it_->clearDir();
 
   // Clear any existing data in the linear solver
-  LS_->clear();
+  {
+    PAUSE_ALLOCATION_COUNT;
+    LS_->clear();
+  }
 
   // compute theta inverse
-  it_->computeScaling();
+  {
+    IPM_TIME_PHASE(stats_, kPhaseScaling, vectorBytes(5));
+    it_->computeScaling();
+  }
 
   return false;
 }
@@ -113,7 +341,10 @@ bool Ipm::predictor() {
 
   // compute sigma and residuals for affine scaling direction
   sigmaAffine();
-  it_->residual56(sigma_);
+  {
+    IPM_TIME_PHASE(stats_, kPhaseResiduals, vectorBytes(8));
+    it_->residual56(sigma_);
+  }
 
   if (solveNewtonSystem(it_->delta)) return true;
   if (recoverDirection(it_->delta)) return true;
@@ -203,17 +434,42 @@ void Ipm::runCrossover() {
 bool Ipm::solveNewtonSystem(NewtonDir& delta) {
   std::vector<double>& theta_inv = it_->scaling;
 
-  std::vector<double> res7 = it_->residual7();
+  std::vector<double>& res7 = work_->res7;
+  std::vector<double>& res8 = work_->res8;
+  int solve_status;
+  {
+    IPM_TIME_PHASE(stats_, kPhaseResiduals, vectorBytes(12));
+    it_->residual7(res7);
+  }
 
   // NORMAL EQUATIONS
   if (options_.nla == kOptionNlaNormEq) {
-    std::vector<double> res8 = it_->residual8(res7);
+    {
+      IPM_TIME_PHASE(stats_, kPhaseResiduals,
+                     vectorBytes(3) + matrixBytes(1));
+      it_->residual8(res7, res8, work_->theta_res7);
+    }
 
-    // factorise normal equations, if not yet done
-    if (!LS_->valid_ && LS_->factorNE(model_.A(), theta_inv)) goto failure;
+    {
+      PAUSE_ALLOCATION_COUNT;
+
+      // factorise normal equations, if not yet done
+      if (!LS_->valid_ && factorise(theta_inv)) goto failure;
+
+      // solve with normal equations
+      {
+        IPM_TIME_PHASE(stats_, kPhaseSolve, solveBytes());
+        solve_status = LS_->solveNE(res8, delta.y);
+      }
+      if (solve_status) goto failure;
 
-    // solve with normal equations
-    if (LS_->solveNE(res8, delta.y)) goto failure;
+      // refine the solution, if requested
+      if (options_.refine != kOptionRefineOff) {
+        IPM_TIME_PHASE(stats_, kPhaseRefine, matrixBytes(3));
+        solve_status = LS_->refineNE(model_.A(), theta_inv, res8, delta.y);
+      }
+      if (solve_status) goto failure;
+    }
 
     // Compute delta.x
     // Deltax = A^T * Deltay - res7;
@@ -229,11 +485,26 @@ bool Ipm::solveNewtonSystem(NewtonDir& delta) {
 
   // AUGMENTED SYSTEM
   else {
+    PAUSE_ALLOCATION_COUNT;
+
     // factorise augmented system, if not yet done
-    if (!LS_->valid_ && LS_->factorAS(model_.A(), theta_inv)) goto failure;
+    if (!LS_->valid_ && factorise(theta_inv)) goto failure;
 
     // solve with augmented system
-    if (LS_->solveAS(res7, it_->res1, delta.x, delta.y)) goto failure;
+    {
+      IPM_TIME_PHASE(stats_, kPhaseSolve, solveBytes());
+      solve_status = LS_->solveAS(res7, it_->res1, delta.x, delta.y);
+    }
+    if (solve_status) goto failure;
+
+    // refine the solution, if requested
+    if (options_.refine != kOptionRefineOff) {
+      IPM_TIME_PHASE(stats_, kPhaseRefine, matrixBytes(3));
+      solve_status =
+          LS_->refineAS(model_.A(), theta_inv, res7, it_->res1, delta.x,
+                        delta.y);
+    }
+    if (solve_status) goto failure;
   }
 
   return false;
@@ -247,6 +518,8 @@ failure:
 
 bool Ipm::recoverDirection(NewtonDir& delta) {
   // Recover components xl, xu, zl, zu of partial direction delta.
+  IPM_TIME_PHASE(stats_, kPhaseRecoverDirection, vectorBytes(16));
+
   std::vector<double>& xl = it_->xl;
   std::vector<double>& xu = it_->xu;
   std::vector<double>& zl = it_->zl;
@@ -257,44 +530,49 @@ bool Ipm::recoverDirection(NewtonDir& delta) {
   std::vector<double>& res5 = it_->res5;
   std::vector<double>& res6 = it_->res6;
 
-  for (int i = 0; i < n_; ++i) {
-    if (model_.hasLb(i) || model_.hasUb(i)) {
-      delta.xl[i] = delta.x[i] - res2[i];
-      delta.zl[i] = (res5[i] - zl[i] * delta.xl[i]) / xl[i];
-    } else {
-      delta.xl[i] = 0.0;
-      delta.zl[i] = 0.0;
-    }
+  // the components of the free variables are zero, the others are computed
+  // only for the variables with at least one finite bound
+  for (int i : model_.freeIndex()) {
+    delta.xl[i] = 0.0;
+    delta.zl[i] = 0.0;
+    delta.xu[i] = 0.0;
+    delta.zu[i] = 0.0;
   }
-  for (int i = 0; i < n_; ++i) {
-    if (model_.hasLb(i) || model_.hasUb(i)) {
-      delta.xu[i] = res3[i] - delta.x[i];
-      delta.zu[i] = (res6[i] - zu[i] * delta.xu[i]) / xu[i];
-    } else {
-      delta.xu[i] = 0.0;
-      delta.zu[i] = 0.0;
-    }
+  for (int i : model_.bndIndex()) {
+    delta.xl[i] = delta.x[i] - res2[i];
+    delta.zl[i] = (res5[i] - zl[i] * delta.xl[i]) / xl[i];
+  }
+  for (int i : model_.bndIndex()) {
+    delta.xu[i] = res3[i] - delta.x[i];
+    delta.zu[i] = (res6[i] - zu[i] * delta.xu[i]) / xu[i];
   }
 
   // not sure if this has any effect, but IPX uses it
-  std::vector<double> Atdy(n_);
+  std::vector<double>& Atdy = work_->Atdy;
+  std::fill(Atdy.begin(), Atdy.end(), 0.0);
   model_.A().alphaProductPlusY(1.0, delta.y, Atdy, true);
-  for (int i = 0; i < n_; ++i) {
-    if (model_.hasLb(i) || model_.hasUb(i)) {
-      if (std::isfinite(xl[i]) && std::isfinite(xu[i])) {
-        if (zl[i] * xu[i] >= zu[i] * xl[i])
-          delta.zl[i] = res4[i] + delta.zu[i] - Atdy[i];
-        else
-          delta.zu[i] = -res4[i] + delta.zl[i] + Atdy[i];
-      } else if (std::isfinite(xl[i])) {
+  for (int i : model_.bndIndex()) {
+    if (std::isfinite(xl[i]) && std::isfinite(xu[i])) {
+      if (zl[i] * xu[i] >= zu[i] * xl[i])
         delta.zl[i] = res4[i] + delta.zu[i] - Atdy[i];
-      } else {
+      else
         delta.zu[i] = -res4[i] + delta.zl[i] + Atdy[i];
-      }
+    } else if (std::isfinite(xl[i])) {
+      delta.zl[i] = res4[i] + delta.zu[i] - Atdy[i];
+    } else {
+      delta.zu[i] = -res4[i] + delta.zl[i] + Atdy[i];
     }
   }
 
-  backwardError(delta);
+  // Diagnostics:
+  // - on: normwise and componentwise backward error of every direction
+  // - sampled: normwise backward error of the predictor, every
+  //   kDiagnosticsFrequency iterations
+  if (options_.diagnostics == kOptionDiagnosticsOn)
+    backwardError(delta, true);
+  else if (options_.diagnostics == kOptionDiagnosticsSampled &&
+           &delta == &it_->delta && iter_ % kDiagnosticsFrequency == 0)
+    backwardError(delta, false);
 
   // Check for NaN of Inf
   if (it_->isDirNan()) {
@@ -309,6 +587,46 @@ bool Ipm::recoverDirection(NewtonDir& delta) {
   return false;
 }
 
+// Minimum ratio -x_i / d_i over the components i = idx[p], p in [start, end),
+// with d_i = dx_i + w * c_i < 0. Returns kHighsInf if no component blocks. If
+// block is valid, it returns the first index that attains the minimum.
+static double minRatio(const double* x, const double* dx, const double* c,
+                       double w, const int* idx, int start, int end,
+                       int* block) {
+  double rmin = kHighsInf;
+  if (c) {
+    for (int p = start; p < end; ++p) {
+      const int i = idx[p];
+      double d = dx[i] + w * c[i];
+      double ratio = d < 0.0 ? -x[i] / d : kHighsInf;
+      rmin = std::min(rmin, ratio);
+    }
+  } else {
+    for (int p = start; p < end; ++p) {
+      const int i = idx[p];
+      double d = dx[i];
+      double ratio = d < 0.0 ? -x[i] / d : kHighsInf;
+      rmin = std::min(rmin, ratio);
+    }
+  }
+
+  if (block) {
+    *block = -1;
+    if (rmin < kHighsInf) {
+      for (int p = start; p < end; ++p) {
+        const int i = idx[p];
+        double d = dx[i] + (c ? w * c[i] : 0.0);
+        if (d < 0.0 && -x[i] / d == rmin) {
+          *block = i;
+          break;
+        }
+      }
+    }
+  }
+
+  return rmin;
+}
+
 double Ipm::stepToBoundary(const std::vector<double>& x,
                            const std::vector<double>& dx,
                            const std::vector<double>* cor, double weight,
@@ -318,22 +636,59 @@ double Ipm::stepToBoundary(const std::vector<double>& x,
   // Use lo=1 for xl and zl, lo=0 for xu and zu.
   // Return the blocking index in block.
 
+  // The step is computed as a min-ratio reduction
+  //  alpha = min_i { -x_i / d_i : d_i < 0 },   d = dx + w * cor,
+  // over the components with a finite bound, which are found in the index
+  // list of the model. Long lists are split into chunks reduced in parallel.
+  // Ties are broken by the smallest index, so the result does not depend on
+  // the number of threads.
+
   const double damp = 1.0 - std::numeric_limits<double>::epsilon();
+  const std::vector<int>& index = lo ? model_.lbIndex() : model_.ubIndex();
+  const int* idx = index.data();
+  const double* c = cor ? cor->data() : nullptr;
+  const double w = cor ? weight : 0.0;
+  const int size = index.size();
 
-  double alpha = 1.0;
+  double rmin;
   int bl = -1;
 
-  for (int i = 0; i < x.size(); ++i) {
-    if ((lo && model_.hasLb(i)) || (!lo && model_.hasUb(i))) {
-      double c = (cor ? (*cor)[i] * weight : 0.0);
-      if (x[i] + alpha * (dx[i] + c) < 0.0) {
-        alpha = -(x[i] * damp) / (dx[i] + c);
-        bl = i;
+  if (size < kParallelStepMin) {
+    rmin = minRatio(x.data(), dx.data(), c, w, idx, 0, size,
+                    block ? &bl : nullptr);
+  } else {
+    const int num_chunks = (size + kStepChunkSize - 1) / kStepChunkSize;
+    std::vector<double>& chunk_ratio = work_->chunk_ratio;
+    std::vector<int>& chunk_block = work_->chunk_block;
+
+    highs::parallel::for_each(
+        0, num_chunks,
+        [&](HighsInt first, HighsInt last) {
+          for (int chunk = first; chunk < last; ++chunk) {
+            int start = chunk * kStepChunkSize;
+            int end = std::min(size, start + kStepChunkSize);
+            chunk_ratio[chunk] =
+                minRatio(x.data(), dx.data(), c, w, idx, start, end,
+                         block ? &chunk_block[chunk] : nullptr);
+          }
+        },
+        1);
+
+    // combine the chunks in order, keeping the first one that attains the
+    // minimum
+    rmin = kHighsInf;
+    for (int chunk = 0; chunk < num_chunks; ++chunk) {
+      if (chunk_ratio[chunk] < rmin) {
+        rmin = chunk_ratio[chunk];
+        if (block) bl = chunk_block[chunk];
       }
     }
   }
+
+  if (rmin >= 1.0) bl = -1;
   if (block) *block = bl;
-  return alpha;
+
+  return rmin < 1.0 ? rmin * damp : 1.0;
 }
 
 void Ipm::stepsToBoundary(double& alpha_primal, double& alpha_dual,
@@ -360,6 +715,8 @@ void Ipm::stepsToBoundary(double& alpha_primal, double& alpha_dual,
 
 void Ipm::stepSizes() {
   // Compute primal and dual stepsizes.
+  IPM_TIME_PHASE(stats_, kPhaseStepSizes, vectorBytes(8));
+
   std::vector<double>& xl = it_->xl;
   std::vector<double>& xu = it_->xu;
   std::vector<double>& zl = it_->zl;
@@ -385,18 +742,11 @@ void Ipm::stepSizes() {
 
   // compute mu with current stepsizes
   double mu_full = 0.0;
-  int num_finite = 0;
-  for (int i = 0; i < n_; ++i) {
-    if (model_.hasLb(i)) {
-      mu_full += (xl[i] + max_p * dxl[i]) * (zl[i] + max_d * dzl[i]);
-      ++num_finite;
-    }
-    if (model_.hasUb(i)) {
-      mu_full += (xu[i] + max_p * dxu[i]) * (zu[i] + max_d * dzu[i]);
-      ++num_finite;
-    }
-  }
-  mu_full /= num_finite;
+  for (int i : model_.lbIndex())
+    mu_full += (xl[i] + max_p * dxl[i]) * (zl[i] + max_d * dzl[i]);
+  for (int i : model_.ubIndex())
+    mu_full += (xu[i] + max_p * dxu[i]) * (zu[i] + max_d * dzu[i]);
+  mu_full /= model_.numFiniteBounds();
   mu_full /= gamma_a;
 
   // compute new stepsizes based on Mehrotra heuristic
@@ -453,24 +803,66 @@ void Ipm::makeStep() {
   else
     bad_iter_ = 0;
 
-  // update iterate
-  vectorAdd(it_->x, it_->delta.x, alpha_primal_);
-  vectorAdd(it_->xl, it_->delta.xl, alpha_primal_);
-  vectorAdd(it_->xu, it_->delta.xu, alpha_primal_);
-  vectorAdd(it_->y, it_->delta.y, alpha_dual_);
-  vectorAdd(it_->zl, it_->delta.zl, alpha_dual_);
-  vectorAdd(it_->zu, it_->delta.zu, alpha_dual_);
-
-  // compute new quantities
-  it_->residual1234();
-  it_->computeMu();
-  it_->indicators();
+  // update iterate and compute new quantities
+  {
+    IPM_TIME_PHASE(stats_, kPhaseStep, vectorBytes(24) + matrixBytes(2));
+    it_->step(alpha_primal_, alpha_dual_);
+  }
 
   collectData();
   printOutput();
+  IPM_END_ITER(stats_, iter_);
+}
+
+void Ipm::warmStartingPoint() {
+  std::vector<double>& x = it_->x;
+  std::vector<double>& xl = it_->xl;
+  std::vector<double>& xu = it_->xu;
+  std::vector<double>& zl = it_->zl;
+  std::vector<double>& zu = it_->zu;
+
+  const double mu = std::max(it_->mu, kWarmStartMu);
+  const double min_val = std::sqrt(mu);
+  const double max_prod = mu / kWarmStartCentre;
+
+  // Given a pair of complementary variables, shift them away from zero and
+  // reduce their product, if too large. The larger one is reduced first; if it
+  // reaches min_val and the product is still too large, the other one is
+  // reduced too. Since max_prod >= min_val^2, both stay above min_val.
+  auto centre = [&](double& v, double& z) {
+    v = std::max(v, min_val);
+    z = std::max(z, min_val);
+    if (v * z > max_prod) {
+      double& large = v >= z ? v : z;
+      double& small = v >= z ? z : v;
+      large = std::max(max_prod / small, min_val);
+      if (large * small > max_prod) small = max_prod / large;
+    }
+  };
+
+  for (int i = 0; i < n_; ++i) {
+    if (model_.hasLb(i)) {
+      xl[i] = x[i] - model_.lb(i);
+      centre(xl[i], zl[i]);
+    } else {
+      // keep the unused components positive, as in the cold start
+      xl[i] = 1.0;
+      zl[i] = 0.0;
+    }
+    if (model_.hasUb(i)) {
+      xu[i] = model_.ub(i) - x[i];
+      centre(xu[i], zu[i]);
+    } else {
+      // keep the unused components positive, as in the cold start
+      xu[i] = 1.0;
+      zu[i] = 0.0;
+    }
+  }
 }
 
 void Ipm::startingPoint() {
+  IPM_TIME_PHASE(stats_, kPhaseStartingPoint, 0.0);
+
   std::vector<double>& x = it_->x;
   std::vector<double>& xl = it_->xl;
   std::vector<double>& xu = it_->xu;
@@ -489,6 +881,7 @@ void Ipm::startingPoint() {
   }
 
   const std::vector<double> temp_scaling(n_, 1.0);
+
   std::vector<double> temp_m(m_);
 
   if (options_.nla == kOptionNlaNormEq) {
@@ -500,21 +893,31 @@ void Ipm::startingPoint() {
     // temp_m
 
     // factorize A*A^T
-    if (LS_->factorNE(model_.A(), temp_scaling)) goto failure;
+    if (factorise(temp_scaling)) goto failure;
 
-    if (LS_->solveNE(y, temp_m)) goto failure;
+    int solve_status;
+    {
+      IPM_TIME_PHASE(stats_, kPhaseSolve, solveBytes());
+      solve_status = LS_->solveNE(y, temp_m);
+    }
+    if (solve_status) goto failure;
 
   } else if (options_.nla == kOptionNlaAugmented) {
     // obtain solution of A*A^T * dx = b-A*x by solving
     // [ -I  A^T] [...] = [ -x]
     // [  A   0 ] [ dx] = [ b ]
 
-    if (LS_->factorAS(model_.A(), temp_scaling)) goto failure;
+    if (factorise(temp_scaling)) goto failure;
 
     std::vector<double> rhs_x(n_);
     for (int i = 0; i < n_; ++i) rhs_x[i] = -x[i];
     std::vector<double> lhs_x(n_);
-    if (LS_->solveAS(rhs_x, model_.b(), lhs_x, temp_m)) goto failure;
+    int solve_status;
+    {
+      IPM_TIME_PHASE(stats_, kPhaseSolve, solveBytes());
+      solve_status = LS_->solveAS(rhs_x, model_.b(), lhs_x, temp_m);
+    }
+    if (solve_status) goto failure;
   }
 
   // compute dx = A^T * (A*A^T)^{-1} * (b-A*x) and store the result in xl
@@ -562,7 +965,12 @@ void Ipm::startingPoint() {
     std::fill(temp_m.begin(), temp_m.end(), 0.0);
     model_.A().alphaProductPlusY(1.0, model_.c(), temp_m);
 
-    if (LS_->solveNE(temp_m, y)) goto failure;
+    int solve_status;
+    {
+      IPM_TIME_PHASE(stats_, kPhaseSolve, solveBytes());
+      solve_status = LS_->solveNE(temp_m, y);
+    }
+    if (solve_status) goto failure;
 
   } else if (options_.nla == kOptionNlaAugmented) {
     // obtain solution of A*A^T * y = A*c by solving
@@ -571,8 +979,12 @@ void Ipm::startingPoint() {
 
     std::vector<double> rhs_y(m_, 0.0);
     std::vector<double> lhs_x(n_);
-
-    if (LS_->solveAS(model_.c(), rhs_y, lhs_x, y)) goto failure;
+    int solve_status;
+    {
+      IPM_TIME_PHASE(stats_, kPhaseSolve, solveBytes());
+      solve_status = LS_->solveAS(model_.c(), rhs_y, lhs_x, y);
+    }
+    if (solve_status) goto failure;
   }
   // *********************************************************************
 
@@ -686,6 +1098,8 @@ void Ipm::sigmaCorrectors() {
 
 void Ipm::residualsMcc() {
   // compute right-hand side for multiple centrality correctors
+  IPM_TIME_PHASE(stats_, kPhaseResiduals, vectorBytes(10));
+
   std::vector<double>& xl = it_->xl;
   std::vector<double>& xu = it_->xu;
   std::vector<double>& zl = it_->zl;
@@ -706,62 +1120,61 @@ void Ipm::residualsMcc() {
   alpha_d = std::max(1.0, alpha_d + kMccIncreaseAlpha);
 
   // compute trial point
-  std::vector<double> xlt = xl;
-  std::vector<double> xut = xu;
-  std::vector<double> zlt = zl;
-  std::vector<double> zut = zu;
+  std::vector<double>& xlt = work_->xlt;
+  std::vector<double>& xut = work_->xut;
+  std::vector<double>& zlt = work_->zlt;
+  std::vector<double>& zut = work_->zut;
+  xlt = xl;
+  xut = xu;
+  zlt = zl;
+  zut = zu;
   vectorAdd(xlt, it_->delta.xl, alpha_p);
   vectorAdd(xut, it_->delta.xu, alpha_p);
   vectorAdd(zlt, it_->delta.zl, alpha_d);
   vectorAdd(zut, it_->delta.zu, alpha_d);
 
-  // compute right-hand side for mcc
-  for (int i = 0; i < n_; ++i) {
-    // res5
-    if (model_.hasLb(i)) {
-      double prod = xlt[i] * zlt[i];
-      if (prod < sigma_ * mu * kGammaCorrector) {
-        // prod is small, we add something positive to res5
+  // compute right-hand side for mcc. The residuals were cleared above, so the
+  // entries without a finite bound are already zero.
+  for (int i : model_.lbIndex()) {
+    double prod = xlt[i] * zlt[i];
+    if (prod < sigma_ * mu * kGammaCorrector) {
+      // prod is small, we add something positive to res5
 
-        double temp = sigma_ * mu * kGammaCorrector - prod;
-        res5[i] += temp;
+      double temp = sigma_ * mu * kGammaCorrector - prod;
+      res5[i] += temp;
 
-      } else if (prod > sigma_ * mu / kGammaCorrector) {
-        // prod is large, we may subtract something large from res5.
-        // limit the amount to subtract to -sigma*mu/gamma
+    } else if (prod > sigma_ * mu / kGammaCorrector) {
+      // prod is large, we may subtract something large from res5.
+      // limit the amount to subtract to -sigma*mu/gamma
 
-        double temp = sigma_ * mu / kGammaCorrector - prod;
-        temp = std::max(temp, -sigma_ * mu / kGammaCorrector);
-        res5[i] += temp;
-      }
-    } else {
-      res5[i] = 0.0;
+      double temp = sigma_ * mu / kGammaCorrector - prod;
+      temp = std::max(temp, -sigma_ * mu / kGammaCorrector);
+      res5[i] += temp;
     }
+  }
 
-    // res6
-    if (model_.hasUb(i)) {
-      double prod = xut[i] * zut[i];
-      if (prod < sigma_ * mu * kGammaCorrector) {
-        // prod is small, we add something positive to res6
+  for (int i : model_.ubIndex()) {
+    double prod = xut[i] * zut[i];
+    if (prod < sigma_ * mu * kGammaCorrector) {
+      // prod is small, we add something positive to res6
 
-        double temp = sigma_ * mu * kGammaCorrector - prod;
-        res6[i] += temp;
+      double temp = sigma_ * mu * kGammaCorrector - prod;
+      res6[i] += temp;
 
-      } else if (prod > sigma_ * mu / kGammaCorrector) {
-        // prod is large, we may subtract something large from res6.
-        // limit the amount to subtract to -sigma*mu/gamma
+    } else if (prod > sigma_ * mu / kGammaCorrector) {
+      // prod is large, we may subtract something large from res6.
+      // limit the amount to subtract to -sigma*mu/gamma
 
-        double temp = sigma_ * mu / kGammaCorrector - prod;
-        temp = std::max(temp, -sigma_ * mu / kGammaCorrector);
-        res6[i] += temp;
-      }
-    } else {
-      res6[i] = 0.0;
+      double temp = sigma_ * mu / kGammaCorrector - prod;
+      temp = std::max(temp, -sigma_ * mu / kGammaCorrector);
+      res6[i] += temp;
     }
   }
 }
 
 bool Ipm::centralityCorrectors() {
+  IPM_TIME_PHASE(stats_, kPhaseCorrectors, 0.0);
+
   // compute stepsizes of current direction
   double alpha_p_old, alpha_d_old;
   stepsToBoundary(alpha_p_old, alpha_d_old, it_->delta);
@@ -770,15 +1183,20 @@ bool Ipm::centralityCorrectors() {
   printf("(%.2f,%.2f) -> ", alpha_p_old, alpha_d_old);
 #endif
 
+  // stepsize before the correctors, to measure their payoff
+  const double alpha_start = std::min(alpha_p_old, alpha_d_old);
+  cor_computed_ = 0;
+
   int cor;
   for (cor = 0; cor < max_correctors_; ++cor) {
     // compute rhs for corrector
     residualsMcc();
 
     // compute corrector
-    NewtonDir corr(m_, n_);
+    NewtonDir& corr = work_->corr;
     if (solveNewtonSystem(corr)) return true;
     if (recoverDirection(corr)) return true;
+    ++cor_computed_;
 
     double alpha_p, alpha_d;
     double wp = alpha_p_old * alpha_d_old;
@@ -827,9 +1245,142 @@ bool Ipm::centralityCorrectors() {
 
   DataCollector::get()->back().correctors = cor;
 
+  cor_accepted_ = cor;
+  cor_payoff_ = (std::min(alpha_p_old, alpha_d_old) - alpha_start) /
+                std::max(alpha_start, kMccIncreaseMin);
+
   return false;
 }
 
+// Evaluation of g(w) = max(1, max_i (a_i + b_i * w)) for the primal or dual
+// variables, see Ipm::bestWeight. side = +1 gives the right derivative at w,
+// side = -1 the left derivative.
+struct WeightQuery {
+  bool dual;
+  double w;
+  int side;
+};
+
+// Keep in r = (value, slope) the line active at the query point. Among lines
+// with the same value, keep the one with largest (side=+1) or smallest
+// (side=-1) slope.
+static void keepActiveLine(double* r, double value, double slope, int side) {
+  if (value > r[0] || (value == r[0] && side * slope > side * r[1])) {
+    r[0] = value;
+    r[1] = slope;
+  }
+}
+
+// Evaluate the queries over the components i = idx[p], p in [start, end),
+// using the lower (xl, zl) or upper (xu, zu) variables. The value and slope
+// of query k are stored in res[2 * k] and res[2 * k + 1].
+static void evalWeightQueries(const IpmIterate& it, const NewtonDir& delta,
+                              const NewtonDir& cor, bool lo, const int* idx,
+                              const WeightQuery* q, int num_q, int start,
+                              int end, double* res) {
+  for (int k = 0; k < num_q; ++k) {
+    res[2 * k] = 1.0;
+    res[2 * k + 1] = 0.0;
+  }
+
+  const std::vector<double>& x = lo ? it.xl : it.xu;
+  const std::vector<double>& z = lo ? it.zl : it.zu;
+  const std::vector<double>& dx = lo ? delta.xl : delta.xu;
+  const std::vector<double>& dz = lo ? delta.zl : delta.zu;
+  const std::vector<double>& cx = lo ? cor.xl : cor.xu;
+  const std::vector<double>& cz = lo ? cor.zl : cor.zu;
+
+  for (int p = start; p < end; ++p) {
+    const int i = idx[p];
+
+    // lines -(Delta_i + w * cor_i) / x_i = a_i + b_i * w
+    const double ax = -dx[i] / x[i], bx = -cx[i] / x[i];
+    const double az = -dz[i] / z[i], bz = -cz[i] / z[i];
+
+    for (int k = 0; k < num_q; ++k) {
+      const double w = q[k].w;
+      if (!q[k].dual)
+        keepActiveLine(&res[2 * k], ax + bx * w, bx, q[k].side);
+      else
+        keepActiveLine(&res[2 * k], az + bz * w, bz, q[k].side);
+    }
+  }
+}
+
+void Ipm::evalWeights(const NewtonDir& delta, const NewtonDir& corrector,
+                      const WeightQuery* q, int num_q, double* res) const {
+  const std::vector<int>& lb_index = model_.lbIndex();
+  const std::vector<int>& ub_index = model_.ubIndex();
+  const int num_lb = lb_index.size();
+  const int num_ub = ub_index.size();
+
+  if (num_lb + num_ub < kParallelStepMin) {
+    double res_ub[8];
+    evalWeightQueries(*it_, delta, corrector, true, lb_index.data(), q, num_q,
+                      0, num_lb, res);
+    evalWeightQueries(*it_, delta, corrector, false, ub_index.data(), q, num_q,
+                      0, num_ub, res_ub);
+    for (int k = 0; k < num_q; ++k)
+      keepActiveLine(&res[2 * k], res_ub[2 * k], res_ub[2 * k + 1], q[k].side);
+    return;
+  }
+
+  // chunks of the lower variables, followed by chunks of the upper variables
+  const int chunks_lb = (num_lb + kStepChunkSize - 1) / kStepChunkSize;
+  const int chunks_ub = (num_ub + kStepChunkSize - 1) / kStepChunkSize;
+  std::vector<double>& chunk_res = work_->chunk_ratio;
+
+  highs::parallel::for_each(
+      0, chunks_lb + chunks_ub,
+      [&](HighsInt first, HighsInt last) {
+        for (int chunk = first; chunk < last; ++chunk) {
+          const bool lo = chunk < chunks_lb;
+          const int local = lo ? chunk : chunk - chunks_lb;
+          const int size = lo ? num_lb : num_ub;
+          const int* idx = lo ? lb_index.data() : ub_index.data();
+          int start = local * kStepChunkSize;
+          int end = std::min(size, start + kStepChunkSize);
+          evalWeightQueries(*it_, delta, corrector, lo, idx, q, num_q, start,
+                            end, &chunk_res[8 * chunk]);
+        }
+      },
+      1);
+
+  // combine the chunks; the result does not depend on their order
+  for (int k = 0; k < num_q; ++k) {
+    res[2 * k] = 1.0;
+    res[2 * k + 1] = 0.0;
+    for (int chunk = 0; chunk < chunks_lb + chunks_ub; ++chunk)
+      keepActiveLine(&res[2 * k], chunk_res[8 * chunk + 2 * k],
+                     chunk_res[8 * chunk + 2 * k + 1], q[k].side);
+  }
+}
+
+// State of the search of the minimum of g in Ipm::bestWeight
+struct WeightSearch {
+  // ends of the bracket, with value of g and slope of the active line
+  double wl, gl, sl;
+  double wr, gr, sr;
+
+  // best point found so far
+  double w, g;
+
+  bool done;
+
+  void update(double w_new, double g_new) {
+    if (g_new < g || (g_new == g && w_new < w)) {
+      w = w_new;
+      g = g_new;
+    }
+  }
+
+  // intersection of the active lines at the ends of the bracket
+  double next() const {
+    double w_new = (gr - gl + sl * wl - sr * wr) / (sl - sr);
+    return std::max(wl, std::min(wr, w_new));
+  }
+};
+
 void Ipm::bestWeight(const NewtonDir& delta, const NewtonDir& corrector,
                      double& wp, double& wd, double& alpha_p,
                      double& alpha_d) const {
@@ -838,31 +1389,85 @@ void Ipm::bestWeight(const NewtonDir& delta, const NewtonDir& corrector,
   // Upon return, wp and wd are the optimal weights, alpha_p and alpha_d are the
   // corresponding stepsizes.
 
-  // keep track of best stepsizes
-  alpha_p = 0.0;
-  alpha_d = 0.0;
+  const double damp = 1.0 - std::numeric_limits<double>::epsilon();
+  const double w0 = std::min(wp, 1.0);
 
-  // initial weight
-  double w = wp;
+  // primal and dual searches
+  WeightSearch s[2];
+  WeightQuery q[4];
+  double res[8];
 
-  // divide interval into 9 points
-  const double step = (1.0 - w) / 8;
+  // First pass: evaluate g and its one-sided derivatives at both ends
+  for (int t = 0; t < 2; ++t) {
+    q[2 * t] = {t == 1, w0, 1};
+    q[2 * t + 1] = {t == 1, 1.0, -1};
+  }
+  evalWeights(delta, corrector, q, 4, res);
+
+  for (int t = 0; t < 2; ++t) {
+    WeightSearch& st = s[t];
+    st.wl = w0;
+    st.gl = res[4 * t];
+    st.sl = res[4 * t + 1];
+    st.wr = 1.0;
+    st.gr = res[4 * t + 2];
+    st.sr = res[4 * t + 3];
+    st.w = st.wl;
+    st.g = st.gl;
+    st.update(st.wr, st.gr);
+
+    // g is non-decreasing from w0, or decreasing up to 1
+    st.done = st.wl >= st.wr || st.sl >= 0.0 || st.sr < 0.0;
+  }
 
-  // for each weight, compute stepsizes and save best ones
-  for (; w <= 1.0; w += step) {
-    double ap, ad;
-    stepsToBoundary(ap, ad, delta, &corrector, w);
-    if (ap > alpha_p) {
-      alpha_p = ap;
-      wp = w;
+  for (int iter = 1; iter < kMaxWeightIter && !(s[0].done && s[1].done);
+       ++iter) {
+    // evaluate both one-sided derivatives at the intersection of the lines
+    int num_q = 0;
+    double w_new[2];
+    for (int t = 0; t < 2; ++t) {
+      if (s[t].done) continue;
+      w_new[t] = s[t].next();
+      q[num_q++] = {t == 1, w_new[t], 1};
+      q[num_q++] = {t == 1, w_new[t], -1};
     }
-    if (ad > alpha_d) {
-      alpha_d = ad;
-      wd = w;
+    evalWeights(delta, corrector, q, num_q, res);
+
+    int k = 0;
+    for (int t = 0; t < 2; ++t) {
+      WeightSearch& st = s[t];
+      if (st.done) continue;
+      const double g = res[2 * k];
+      const double right_slope = res[2 * k + 1];
+      const double left_slope = res[2 * k + 3];
+      k += 2;
+
+      st.update(w_new[t], g);
+
+      if (w_new[t] <= st.wl || w_new[t] >= st.wr) {
+        // no progress possible
+        st.done = true;
+      } else if (left_slope < 0.0 && right_slope >= 0.0) {
+        // minimum, and smallest weight attaining it
+        st.done = true;
+      } else if (left_slope >= 0.0) {
+        // minimum is at w_new or on its left
+        st.wr = w_new[t];
+        st.gr = g;
+        st.sr = left_slope;
+      } else {
+        // minimum is on the right of w_new
+        st.wl = w_new[t];
+        st.gl = g;
+        st.sl = right_slope;
+      }
     }
-
-    if (step == 0.0) break;
   }
+
+  wp = s[0].w;
+  wd = s[1].w;
+  alpha_p = s[0].g > 1.0 ? damp / s[0].g : 1.0;
+  alpha_d = s[1].g > 1.0 ? damp / s[1].g : 1.0;
 }
 
 bool Ipm::checkIterate() {
@@ -926,7 +1531,10 @@ bool Ipm::checkTermination() {
   return terminate;
 }
 
-void Ipm::backwardError(const NewtonDir& delta) const {
+void Ipm::backwardError(const NewtonDir& delta, bool componentwise) const {
+  IPM_TIME_PHASE(stats_, kPhaseBackwardError,
+                 vectorBytes(20) + matrixBytes(componentwise ? 4 : 2));
+
   std::vector<double>& x = it_->x;
   std::vector<double>& xl = it_->xl;
   std::vector<double>& xu = it_->xu;
@@ -946,34 +1554,39 @@ void Ipm::backwardError(const NewtonDir& delta) const {
 
   // residuals of the six blocks of equations
   // res1 - A * dx
-  std::vector<double> r1 = res1;
+  std::vector<double>& r1 = work_->r1;
+  r1 = res1;
   model_.A().alphaProductPlusY(-1.0, delta.x, r1);
 
   // res2 - dx + dxl
-  std::vector<double> r2(n_);
+  std::vector<double>& r2 = work_->r2;
   for (int i = 0; i < n_; ++i) r2[i] = res2[i] - delta.x[i] + delta.xl[i];
 
   // res3 - dx - dxu
-  std::vector<double> r3(n_);
+  std::vector<double>& r3 = work_->r3;
   for (int i = 0; i < n_; ++i) r3[i] = res3[i] - delta.x[i] - delta.xu[i];
 
   // res4 - A^T * dy - dzl + dzu
-  std::vector<double> r4(n_);
+  std::vector<double>& r4 = work_->r4;
   for (int i = 0; i < n_; ++i) r4[i] = res4[i] - delta.zl[i] + delta.zu[i];
   model_.A().alphaProductPlusY(-1.0, delta.y, r4, true);
 
   // res5 - Zl * Dxl - Xl * Dzl
-  std::vector<double> r5(n_);
+  std::vector<double>& r5 = work_->r5;
   for (int i = 0; i < n_; ++i) {
     if (model_.hasLb(i))
       r5[i] = res5[i] - zl[i] * delta.xl[i] - xl[i] * delta.zl[i];
+    else
+      r5[i] = 0.0;
   }
 
   // res6 - Zu * Dxu - Xu * Dzu
-  std::vector<double> r6(n_);
+  std::vector<double>& r6 = work_->r6;
   for (int i = 0; i < n_; ++i) {
     if (model_.hasUb(i))
       r6[i] = res6[i] - zu[i] * delta.xu[i] - xu[i] * delta.zu[i];
+    else
+      r6[i] = 0.0;
   }
 
   // ...and their infinity norm
@@ -1005,23 +1618,8 @@ void Ipm::backwardError(const NewtonDir& delta) const {
 
   // infinity norm of big 6x6 matrix:
   // max( ||A||_inf, 2, 2+||A||_1, max_j(zl_j+xl_j), max_j(zu_j+xu_j) )
-
-  std::vector<double> norm_cols_A(n_);
-  std::vector<double> norm_rows_A(m_);
-  for (int col = 0; col < n_; ++col) {
-    for (int el = model_.A().start_[col]; el < model_.A().start_[col + 1];
-         ++el) {
-      int row = model_.A().index_[el];
-      double val = model_.A().value_[el];
-      norm_cols_A[col] += std::abs(val);
-      norm_rows_A[row] += std::abs(val);
-    }
-  }
-  double one_norm_A = *std::max_element(norm_cols_A.begin(), norm_cols_A.end());
-  double inf_norm_A = *std::max_element(norm_rows_A.begin(), norm_rows_A.end());
-
-  double inf_norm_matrix = inf_norm_A;
-  inf_norm_matrix = std::max(inf_norm_matrix, one_norm_A + 2);
+  double inf_norm_matrix = inf_norm_A_;
+  inf_norm_matrix = std::max(inf_norm_matrix, one_norm_A_ + 2);
   for (int i = 0; i < n_; ++i) {
     if (model_.hasLb(i))
       inf_norm_matrix = std::max(inf_norm_matrix, zl[i] + xl[i]);
@@ -1037,13 +1635,17 @@ void Ipm::backwardError(const NewtonDir& delta) const {
   DataCollector::get()->back().nw_back_err =
       std::max(DataCollector::get()->back().nw_back_err, nw_back_err);
 
+  if (!componentwise) return;
+
   // ===================================================================================
   // Componentwise backward error
   // ===================================================================================
 
   // Compute |A| * |dx| and |A^T| * |dy|
-  std::vector<double> abs_prod_A(m_);
-  std::vector<double> abs_prod_At(n_);
+  std::vector<double>& abs_prod_A = work_->abs_prod_A;
+  std::vector<double>& abs_prod_At = work_->abs_prod_At;
+  std::fill(abs_prod_A.begin(), abs_prod_A.end(), 0.0);
+  std::fill(abs_prod_At.begin(), abs_prod_At.end(), 0.0);
   for (int col = 0; col < n_; ++col) {
     for (int el = model_.A().start_[col]; el < model_.A().start_[col + 1];
          ++el) {
@@ -1148,9 +1750,12 @@ void Ipm::printInfo() const {
   printf("Problem %s\n", model_.name().c_str());
   printf("%.2e rows, %.2e cols, %.2e nnz\n", (double)m_, (double)n_,
          (double)model_.A().numNz());
-  printf("Using %s\n", options_.nla == kOptionNlaAugmented
-                           ? "augmented systems"
-                           : "normal equations");
+  if (options_.nla == kOptionNlaChoose)
+    printf("Choosing between augmented systems and normal equations\n");
+  else
+    printf("Using %s\n", options_.nla == kOptionNlaAugmented
+                             ? "augmented systems"
+                             : "normal equations");
 
 #if (defined(PARALLEL_TREE) || defined(PARALLEL_NODE))
   printf("Running on %d threads\n", highs::parallel::num_threads());
@@ -1192,27 +1797,25 @@ void Ipm::collectData() const {
   double& maxdzl = DataCollector::get()->back().max_dzl;
   double& maxdzu = DataCollector::get()->back().max_dzu;
 
-  for (int i = 0; i < n_; ++i) {
-    if (model_.hasLb(i)) {
-      minxl = std::min(minxl, std::abs(it_->xl[i]));
-      maxxl = std::max(maxxl, std::abs(it_->xl[i]));
-      minzl = std::min(minzl, std::abs(it_->zl[i]));
-      maxzl = std::max(maxzl, std::abs(it_->zl[i]));
-      mindxl = std::min(mindxl, std::abs(it_->delta.xl[i]));
-      maxdxl = std::max(maxdxl, std::abs(it_->delta.xl[i]));
-      mindzl = std::min(mindzl, std::abs(it_->delta.zl[i]));
-      maxdzl = std::max(maxdzl, std::abs(it_->delta.zl[i]));
-    }
-    if (model_.hasUb(i)) {
-      minxu = std::min(minxu, std::abs(it_->xu[i]));
-      maxxu = std::max(maxxu, std::abs(it_->xu[i]));
-      minzu = std::min(minzu, std::abs(it_->zu[i]));
-      maxzu = std::max(maxzu, std::abs(it_->zu[i]));
-      mindxu = std::min(mindxu, std::abs(it_->delta.xu[i]));
-      maxdxu = std::max(maxdxu, std::abs(it_->delta.xu[i]));
-      mindzu = std::min(mindzu, std::abs(it_->delta.zu[i]));
-      maxdzu = std::max(maxdzu, std::abs(it_->delta.zu[i]));
-    }
+  for (int i : model_.lbIndex()) {
+    minxl = std::min(minxl, std::abs(it_->xl[i]));
+    maxxl = std::max(maxxl, std::abs(it_->xl[i]));
+    minzl = std::min(minzl, std::abs(it_->zl[i]));
+    maxzl = std::max(maxzl, std::abs(it_->zl[i]));
+    mindxl = std::min(mindxl, std::abs(it_->delta.xl[i]));
+    maxdxl = std::max(maxdxl, std::abs(it_->delta.xl[i]));
+    mindzl = std::min(mindzl, std::abs(it_->delta.zl[i]));
+    maxdzl = std::max(maxdzl, std::abs(it_->delta.zl[i]));
+  }
+  for (int i : model_.ubIndex()) {
+    minxu = std::min(minxu, std::abs(it_->xu[i]));
+    maxxu = std::max(maxxu, std::abs(it_->xu[i]));
+    minzu = std::min(minzu, std::abs(it_->zu[i]));
+    maxzu = std::max(maxzu, std::abs(it_->zu[i]));
+    mindxu = std::min(mindxu, std::abs(it_->delta.xu[i]));
+    maxdxu = std::max(maxdxu, std::abs(it_->delta.xu[i]));
+    mindzu = std::min(mindzu, std::abs(it_->delta.zu[i]));
+    maxdzu = std::max(maxdzu, std::abs(it_->delta.zu[i]));
   }
 
   if (minxl == std::numeric_limits<double>::max()) minxl = 0.0;
@@ -1225,7 +1828,68 @@ void Ipm::collectData() const {
   if (mindzu == std::numeric_limits<double>::max()) mindzu = 0.0;
 }
 
+void Ipm::logIteration() const {
+  if (!log_) return;
+
+  const auto& data = DataCollector::get()->back();
+  IterLogRecord rec{};
+  rec.iter = iter_;
+  rec.correctors = data.correctors;
+  rec.p_obj = data.p_obj;
+  rec.d_obj = data.d_obj;
+  rec.p_inf = data.p_inf;
+  rec.d_inf = data.d_inf;
+  rec.mu = data.mu;
+  rec.pd_gap = data.pd_gap;
+  rec.p_alpha = data.p_alpha;
+  rec.d_alpha = data.d_alpha;
+  rec.sigma_aff = data.sigma_aff;
+  rec.sigma = data.sigma;
+  rec.min_xl = data.min_xl;
+  rec.max_xl = data.max_xl;
+  rec.min_xu = data.min_xu;
+  rec.max_xu = data.max_xu;
+  rec.min_zl = data.min_zl;
+  rec.max_zl = data.max_zl;
+  rec.min_zu = data.min_zu;
+  rec.max_zu = data.max_zu;
+  rec.min_dxl = data.min_dxl;
+  rec.max_dxl = data.max_dxl;
+  rec.min_dxu = data.min_dxu;
+  rec.max_dxu = data.max_dxu;
+  rec.min_dzl = data.min_dzl;
+  rec.max_dzl = data.max_dzl;
+  rec.min_dzu = data.min_dzu;
+  rec.max_dzu = data.max_dzu;
+  rec.min_theta = data.min_theta;
+  rec.max_theta = data.max_theta;
+  rec.min_prod = data.min_prod;
+  rec.max_prod = data.max_prod;
+  rec.num_small_prod = data.num_small_prod;
+  rec.num_large_prod = data.num_large_prod;
+
+  // times are available only if the statistics are compiled in
+  if (!stats_.iters().empty()) {
+    const IterStats& is = stats_.iters().back();
+    rec.time = is.time;
+    rec.factorise_time = is.phase_time[kPhaseFactorise];
+    rec.solve_time = is.phase_time[kPhaseSolve];
+  }
+
+  log_->push(rec);
+}
+
 int Ipm::getIter() const { return iter_; }
+double Ipm::getAnalyseTime() const {
+  return stats_.phase(kPhaseAnalyse).time;
+}
+double Ipm::getFactoriseTime() const {
+  return stats_.phase(kPhaseFactorise).time;
+}
+double Ipm::getSolveTime() const { return stats_.phase(kPhaseSolve).time; }
+double Ipm::getIpmTime() const { return ipm_time_; }
+double Ipm::getNz() const { return LS_ ? LS_->nz() : 0.0; }
+double Ipm::getFlops() const { return LS_ ? LS_->flops() : 0.0; }
 void Ipm::getSolution(std::vector<double>& x, std::vector<double>& xl,
                       std::vector<double>& xu, std::vector<double>& slack,
                       std::vector<double>& y, std::vector<double>& zl,
@@ -1267,11 +1931,16 @@ void Ipm::maxCorrectors() {
 
     // The factorise phase uses BLAS-3 and can be parallelized, the solve phase
     // uses BLAS-2 and cannot be parallelized. To account for this, the
-    // factorisation effort is multiplied by a coefficient < 1, estimated
-    // empirically.
-    double alpha = 1.0 / 112.0;
+    // factorisation effort is multiplied by a coefficient < 1.
+    fact_effort *= kFactoriseEffortWeight;
 
-    double ratio = alpha * fact_effort / solv_effort;
+    // With k dense columns, the factorisation also needs k solves with L, and
+    // each solve needs 2*k*m more operations with the matrix W.
+    const int k = LS_->numDenseCols();
+    fact_effort += k * 2.0 * LS_->nz();
+    solv_effort += 2.0 * k * m_;
+
+    double ratio = fact_effort / solv_effort;
 
     // At each ipm iteration, there are up to (1+k) directions computed, where k
     // is the number of correctors. Each direction requires up (1+f) solves,
@@ -1291,4 +1960,58 @@ void Ipm::maxCorrectors() {
   } else {
     max_correctors_ = -kMaxCorrectors;
   }
-}
\ No newline at end of file
+}
+
+// moving average of the measurements, with weight kAdaptiveCorrectorsWeight on
+// the last one
+static void updateAverage(double& avg, double value, bool first) {
+  avg = first ? value
+              : (1.0 - kAdaptiveCorrectorsWeight) * avg +
+                    kAdaptiveCorrectorsWeight * value;
+}
+
+void Ipm::adaptCorrectors() {
+  // a non-positive kMaxCorrectors fixes the number of correctors
+  if (kMaxCorrectors <= 0 || stats_.iters().empty()) return;
+
+  // the first iterations include the setup and are not representative
+  if (iter_ <= kAdaptiveCorrectorsWarmup) return;
+
+  const IterStats& is = stats_.iters().back();
+  const long long num_solves = is.phase_calls[kPhaseSolve];
+  if (is.phase_calls[kPhaseFactorise] == 0 || num_solves == 0) return;
+
+  const bool first = num_cor_measured_ == 0;
+  updateAverage(avg_factorise_time_, is.phase_time[kPhaseFactorise], first);
+  updateAverage(avg_solve_time_, is.phase_time[kPhaseSolve] / num_solves,
+                first);
+  updateAverage(avg_iter_time_, is.time, first);
+  if (cor_computed_ > 0) {
+    updateAverage(avg_cor_payoff_, cor_payoff_ / cor_computed_, first);
+    updateAverage(avg_cor_accepted_, cor_accepted_, first);
+  }
+  ++num_cor_measured_;
+
+  if (avg_solve_time_ <= 0.0 || avg_iter_time_ <= 0.0) return;
+
+  // same criterion as maxCorrectors, (1+k)(1+f/2) < ratio, with the measured
+  // ratio of factorise and solve times
+  const double ratio = avg_factorise_time_ / avg_solve_time_;
+  const double thresh = ratio / (1.0 + kMaxRefinementIter / 2.0) - 1;
+  int new_max = std::floor(thresh);
+
+  // each corrector costs roughly one solve; if it does not pay for itself,
+  // do not try more correctors than are usually accepted
+  const double cost = avg_solve_time_ / avg_iter_time_;
+  if (avg_cor_payoff_ < cost)
+    new_max = std::min(new_max, (int)std::round(avg_cor_accepted_));
+
+  new_max = std::max(new_max, 1);
+  new_max = std::min(new_max, kMaxCorrectors);
+
+  if (new_max != max_correctors_) {
+    printf("Using %d correctors, measured ratio %.1f, payoff %.1e, cost %.1e\n",
+           new_max, ratio, avg_cor_payoff_, cost);
+    max_correctors_ = new_max;
+  }
+}
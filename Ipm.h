@@ -7,12 +7,16 @@
 #include "FactorHiGHSSolver.h"
 #include "IpmIterate.h"
 #include "IpmModel.h"
+#include "IpmStats.h"
+#include "IterationLog.h"
 #include "Ipm_const.h"
 #include "LinearSolver.h"
 #include "VectorOperations.h"
 #include "ipm/ipx/lp_solver.h"
 #include "util/HighsSparseMatrix.h"
 
+struct WeightQuery;
+
 class Ipm {
   // LP model
   IpmModel model_;
@@ -23,6 +27,9 @@ class Ipm {
   // Iterate object interface
   std::unique_ptr<IpmIterate> it_;
 
+  // Temporary vectors used during the iterations
+  std::unique_ptr<IpmWorkspace> work_;
+
   // Size of the problem
   int m_{}, n_{};
 
@@ -32,6 +39,9 @@ class Ipm {
   // Other statistics
   double min_prod_{}, max_prod_{};
 
+  // Norms of the constraint matrix, used for the backward error
+  double one_norm_A_{}, inf_norm_A_{};
+
   // Stepsizes
   double alpha_primal_{}, alpha_dual_{};
 
@@ -47,12 +57,45 @@ class Ipm {
   // Timer for iterations
   Clock clock_;
 
+  // Time spent in the whole ipm during the last call to solve
+  double ipm_time_{};
+
+  // Time, calls and bytes of each phase, and per-iteration records. Mutable,
+  // so that const diagnostics can be timed.
+  mutable IpmStats stats_{};
+
+  // Asynchronous log of the iterations, if requested
+  std::unique_ptr<IterationLog> log_;
+
   // Interface to ipx
   ipx::LpSolver ipx_lps_;
   bool ipx_used_ = false;
 
   int max_correctors_{};
 
+  // Measurements used to adapt the number of correctors: moving averages of
+  // the time of a factorisation, of a solve and of an iteration, of the
+  // relative increase of the stepsize per corrector computed and of the
+  // number of correctors accepted.
+  double avg_factorise_time_{};
+  double avg_solve_time_{};
+  double avg_iter_time_{};
+  double avg_cor_payoff_{};
+  double avg_cor_accepted_{};
+  int num_cor_measured_{};
+
+  // Correctors computed and accepted in the current iteration, and relative
+  // increase of the stepsize obtained
+  int cor_computed_{};
+  int cor_accepted_{};
+  double cor_payoff_{};
+
+  // Linear solver set up successfully for the model loaded
+  bool setup_ok_ = false;
+
+  // Next solve starts from the previous iterate, reusing the linear solver
+  bool warm_start_ = false;
+
  public:
   // ===================================================================================
   // Load an LP:
@@ -80,6 +123,63 @@ class Ipm {
             const Options& options       // options
   );
 
+  // ===================================================================================
+  // Load an LP, as above, taking ownership of the vectors. The model adopts
+  // their buffers instead of copying them, so that only one copy of the data
+  // exists while solving. The sizes must match the LP exactly: obj, lower and
+  // upper have num_var entries, rhs and constraints num_con, A_ptr num_var + 1,
+  // A_rows and A_vals A_ptr[num_var]. Otherwise, nothing is loaded.
+  //
+  // A slack is appended for each inequality constraint. To avoid reallocating
+  // the buffers, obj, lower, upper, A_ptr, A_rows and A_vals should have
+  // capacity for num_con more entries than their size.
+  // ===================================================================================
+  void load(const int num_var, const int num_con, std::vector<double>&& obj,
+            std::vector<double>&& rhs, std::vector<double>&& lower,
+            std::vector<double>&& upper, std::vector<int>&& A_ptr,
+            std::vector<int>&& A_rows, std::vector<double>&& A_vals,
+            std::vector<char>&& constraints, double offset,
+            const std::string& pb_name, const Options& options);
+
+  // ===================================================================================
+  // Reserve, in the vectors to be filled with an LP with num_col columns,
+  // num_row rows and num_nz nonzeros, the space for the columns and slacks
+  // added to the LP, at most one per row, so that the vectors can be passed
+  // to load without reallocating them. Call it before filling the vectors.
+  // ===================================================================================
+  static void reserveForSlacks(int num_col, int num_row, int num_nz,
+                               std::vector<double>& obj,
+                               std::vector<double>& lower,
+                               std::vector<double>& upper,
+                               std::vector<int>& A_ptr,
+                               std::vector<int>& A_rows,
+                               std::vector<double>& A_vals);
+
+  // ===================================================================================
+  // Load an LP from a snapshot written by writeSnapshot. The snapshot contains
+  // the model already reformulated and scaled, so the scaling options are
+  // ignored. Return false if the file is not a valid snapshot.
+  // ===================================================================================
+  bool loadSnapshot(const std::string& file_name, const Options& options);
+
+  // ===================================================================================
+  // Write the model loaded to a binary snapshot, to be read by loadSnapshot.
+  // Return false if the file could not be written.
+  // ===================================================================================
+  bool writeSnapshot(const std::string& file_name) const;
+
+  // ===================================================================================
+  // Modify the LP loaded, after it has been solved, by replacing cost, rhs or
+  // bounds (nullptr leaves the corresponding data unchanged). The arrays have
+  // the size of the original problem and are copied.
+  //
+  // The next call to solve reuses the scaling of the model and the symbolic
+  // factorisation of the linear solver, skipping the analyse phase, and starts
+  // from the previous iterate, shifted and re-centred.
+  // ===================================================================================
+  void update(const double* obj, const double* rhs, const double* lower,
+              const double* upper);
+
   // ===================================================================================
   // Solve the LP
   // ===================================================================================
@@ -96,14 +196,43 @@ class Ipm {
                    std::vector<double>& y, std::vector<double>& z) const;
   int getIter() const;
 
+  // Times of the last call to solve, in seconds. Analyse time is zero after a
+  // warm start, which reuses the symbolic factorisation.
+  double getAnalyseTime() const;
+  double getFactoriseTime() const;
+  double getSolveTime() const;
+  double getIpmTime() const;
+
+  // Number of nonzeros in the factor and flops of one factorisation
+  double getNz() const;
+  double getFlops() const;
+
+  // Statistics of the phases of the last call to solve
+  const IpmStats& stats() const { return stats_; }
+
  private:
   // Functions to run the various stages of the ipm
   void runIpm();
   bool initialize();
+  bool initializeWarm();
+  void resetStatus();
   bool prepareIter();
   bool predictor();
   bool correctors();
 
+  // Factorise the augmented system or normal equations, depending on the
+  // options, with the given scaling, and accumulate the time spent. Return
+  // nonzero if the linear solver failed.
+  int factorise(const std::vector<double>& scaling);
+
+  // Rough estimates of the bytes touched by a kernel, used by the statistics:
+  // num vectors of size n, num passes over A, one solve with the factor.
+  double vectorBytes(int num) const { return 8.0 * num * n_; }
+  double matrixBytes(int num) const {
+    return 12.0 * num * model_.A().numNz();
+  }
+  double solveBytes() const { return LS_ ? 16.0 * LS_->nz() : 0.0; }
+
   // ===================================================================================
   // Load model and parameters into ipx and set the last iterate as starting
   // point.
@@ -129,6 +258,21 @@ class Ipm {
   // ===================================================================================
   void maxCorrectors();
 
+  // ===================================================================================
+  // Re-tune the maximum number of correctors from the measured cost of
+  // factorise and solve, instead of the estimate of maxCorrectors.
+  //
+  // The measured ratio of factorise and solve times replaces the flops ratio
+  // of maxCorrectors; since these are wall-clock times, they account for the
+  // number of threads used by each phase. If the correctors computed so far
+  // increase the stepsize by less than what they cost, relative to the whole
+  // iteration, the number is also limited to the correctors that are usually
+  // accepted.
+  //
+  // Requires the statistics; does nothing if they are compiled out.
+  // ===================================================================================
+  void adaptCorrectors();
+
   // ===================================================================================
   // Solve:
   //
@@ -212,6 +356,18 @@ class Ipm {
   // ===================================================================================
   void startingPoint();
 
+  // ===================================================================================
+  // Starting point for a warm start, obtained from the previous iterate:
+  // - xl, xu are recomputed from x and the new bounds;
+  // - xl, xu, zl, zu are shifted to be at least sqrt(mu), where mu is the
+  //   previous value of mu, but at least kWarmStartMu;
+  // - the large complementarity products are reduced to mu / kWarmStartCentre
+  //   by decreasing the larger of the two components, and also the smaller
+  //   one if the larger reaches sqrt(mu).
+  // y is unchanged.
+  // ===================================================================================
+  void warmStartingPoint();
+
   // ===================================================================================
   // Compute the sigma to use for affine scaling direction or correctors, based
   // on the smallest stepsize of the previous iteration.
@@ -253,11 +409,27 @@ class Ipm {
   // ===================================================================================
   // Given the current direction delta and the latest corrector, compute the
   // best primal and dual weights, that maximize the primal and dual stepsize.
+  //
+  // For a weight w, the primal stepsize is alpha_p(w) = 1 / g(w), where
+  //  g(w) = max( 1, max_i (a_i + b_i * w) ),
+  //  a_i = -Deltax_i / x_i,   b_i = -cor_i / x_i,
+  // over the primal components x = xl, xu with a finite bound, and similarly
+  // for the dual stepsize. g is convex and piecewise linear, so its minimum on
+  // [wp, 1] is found exactly by cutting planes: the active lines at the ends
+  // of a bracket are intersected and the bracket is updated with the slope of
+  // the active line at the intersection. Primal and dual are evaluated in the
+  // same pass over the data and at most kMaxWeightIter passes are done. If
+  // the minimum is attained on an interval, the smallest weight is returned.
   // ===================================================================================
   void bestWeight(const NewtonDir& delta, const NewtonDir& corrector,
                   double& wp, double& wd, double& alpha_p,
                   double& alpha_d) const;
 
+  // evaluate g and the slope of its active line for the weights in q, in a
+  // single pass over the data
+  void evalWeights(const NewtonDir& delta, const NewtonDir& corrector,
+                   const WeightQuery* q, int num_q, double* res) const;
+
   // ===================================================================================
   // If the current iterate is nan or inf, abort the iterations.
   // ===================================================================================
@@ -277,10 +449,16 @@ class Ipm {
   bool checkTermination();
 
   // ===================================================================================
-  // Compute the normwise and componentwise backward error for the large 6x6
-  // linear system
+  // Compute the normwise and, if requested, componentwise backward error for
+  // the large 6x6 linear system
   // ===================================================================================
-  void backwardError(const NewtonDir& delta) const;
+  void backwardError(const NewtonDir& delta, bool componentwise) const;
+
+  // ===================================================================================
+  // Compute the 1-norm and infinity-norm of A, which do not change during the
+  // iterations
+  // ===================================================================================
+  void computeNormsA();
 
   // ===================================================================================
   // Print to screen
@@ -290,6 +468,11 @@ class Ipm {
   void printOutput() const;
 
   void collectData() const;
+
+  // ===================================================================================
+  // Send the data of the last iteration to the iteration log, if any
+  // ===================================================================================
+  void logIteration() const;
 };
 
 #endif
@@ -6,6 +6,29 @@
 NewtonDir::NewtonDir(int m, int n)
     : x(n, 0.0), y(m, 0.0), xl(n, 0.0), xu(n, 0.0), zl(n, 0.0), zu(n, 0.0) {}
 
+IpmWorkspace::IpmWorkspace(int m, int n)
+    : res7(n),
+      res8(m),
+      theta_res7(n),
+      Atdy(n),
+      xlt(n),
+      xut(n),
+      zlt(n),
+      zut(n),
+      corr(m, n),
+      r1(m),
+      r2(n),
+      r3(n),
+      r4(n),
+      r5(n),
+      r6(n),
+      abs_prod_A(m),
+      abs_prod_At(n) {
+  int num_chunks = (n + kStepChunkSize - 1) / kStepChunkSize;
+  chunk_ratio.resize(16 * num_chunks);
+  chunk_block.resize(num_chunks);
+}
+
 IpmIterate::IpmIterate(const IpmModel& model_input)
     : model{&model_input}, delta(model->m(), model->n()) {
   clearIter();
@@ -49,30 +72,31 @@ bool IpmIterate::isDirInf() const {
   return false;
 }
 
+// The loops below use the index lists or the masks of finite bounds instead of
+// branching on hasLb/hasUb. Entries of xl, xu, zl, zu without a corresponding
+// bound are finite but meaningless, so they are skipped, discarded by
+// multiplying by the mask or by selecting, never by dividing.
+
 void IpmIterate::computeMu() {
   mu = 0.0;
-  int number_finite_bounds{};
-  for (int i = 0; i < model->n(); ++i) {
-    if (model->hasLb(i)) {
-      mu += xl[i] * zl[i];
-      ++number_finite_bounds;
-    }
-    if (model->hasUb(i)) {
-      mu += xu[i] * zu[i];
-      ++number_finite_bounds;
-    }
-  }
-  mu /= number_finite_bounds;
+  for (int i : model->lbIndex()) mu += xl[i] * zl[i];
+  for (int i : model->ubIndex()) mu += xu[i] * zu[i];
+  mu /= model->numFiniteBounds();
 }
 void IpmIterate::computeScaling() {
-  scaling.assign(model->n(), 0.0);
+  const double* lbm = model->lbMask().data();
+  const double* ubm = model->ubMask().data();
+  const int n = model->n();
 
-  for (int i = 0; i < model->n(); ++i) {
-    if (model->hasLb(i)) scaling[i] += zl[i] / xl[i];
-    if (model->hasUb(i)) scaling[i] += zu[i] / xu[i];
+  scaling.resize(n);
+
+  for (int i = 0; i < n; ++i) {
+    double sl = lbm[i] != 0.0 ? zl[i] / xl[i] : 0.0;
+    double su = ubm[i] != 0.0 ? zu[i] / xu[i] : 0.0;
+    double s = sl + su;
 
     // slow down the growth of theta
-    if (scaling[i] < 1e-12) scaling[i] = sqrt(1e-12 * scaling[i]);
+    scaling[i] = s < 1e-12 ? std::sqrt(1e-12 * s) : s;
   }
 
   // compute min and max entry in Theta
@@ -80,7 +104,7 @@ void IpmIterate::computeScaling() {
   double& max_theta = DataCollector::get()->back().max_theta;
   min_theta = kHighsInf;
   max_theta = 0.0;
-  for (int i = 0; i < model->n(); ++i) {
+  for (int i = 0; i < n; ++i) {
     if (scaling[i] != 0.0) {
       min_theta = std::min(min_theta, 1.0 / scaling[i]);
       max_theta = std::max(max_theta, 1.0 / scaling[i]);
@@ -93,8 +117,92 @@ void IpmIterate::products() {
   int num_small = 0;
   int num_large = 0;
 
-  for (int i = 0; i < model->n(); ++i) {
+  for (int i : model->lbIndex()) {
+    double prod = xl[i] * zl[i] / mu;
+    min_prod = std::min(min_prod, prod);
+    max_prod = std::max(max_prod, prod);
+    num_small += (prod < kSmallProduct);
+    num_large += (prod > kLargeProduct);
+  }
+  for (int i : model->ubIndex()) {
+    double prod = xu[i] * zu[i] / mu;
+    min_prod = std::min(min_prod, prod);
+    max_prod = std::max(max_prod, prod);
+    num_small += (prod < kSmallProduct);
+    num_large += (prod > kLargeProduct);
+  }
+
+  DataCollector::get()->back().min_prod = min_prod;
+  DataCollector::get()->back().max_prod = max_prod;
+  DataCollector::get()->back().num_small_prod = num_small;
+  DataCollector::get()->back().num_large_prod = num_large;
+}
+
+void IpmIterate::step(double alpha_p, double alpha_d) {
+  const int n = model->n();
+
+  // ===================================================================================
+  // First pass: update the iterate and compute res2, res3, mu and the objective
+  // terms of the columns
+  // ===================================================================================
+  double mu_sum = 0.0;
+  int number_finite_bounds = 0;
+  double cx = 0.0;
+  double bound_terms = 0.0;
+  double inf_norm_res23 = 0.0;
+
+  for (int i = 0; i < n; ++i) {
+    x[i] += alpha_p * delta.x[i];
+    xl[i] += alpha_p * delta.xl[i];
+    xu[i] += alpha_p * delta.xu[i];
+    zl[i] += alpha_d * delta.zl[i];
+    zu[i] += alpha_d * delta.zu[i];
+
+    cx += x[i] * model->c()[i];
+
+    if (model->hasLb(i)) {
+      res2[i] = model->lb(i) - x[i] + xl[i];
+      inf_norm_res23 = std::max(inf_norm_res23, std::abs(res2[i]));
+      mu_sum += xl[i] * zl[i];
+      ++number_finite_bounds;
+      bound_terms += model->lb(i) * zl[i];
+    } else
+      res2[i] = 0.0;
+
+    if (model->hasUb(i)) {
+      res3[i] = model->ub(i) - x[i] - xu[i];
+      inf_norm_res23 = std::max(inf_norm_res23, std::abs(res3[i]));
+      mu_sum += xu[i] * zu[i];
+      ++number_finite_bounds;
+      bound_terms -= model->ub(i) * zu[i];
+    } else
+      res3[i] = 0.0;
+  }
+  mu = mu_sum / number_finite_bounds;
+
+  vectorAdd(y, delta.y, alpha_d);
+
+  // ===================================================================================
+  // Products with A
+  // ===================================================================================
+  res1 = model->b();
+  model->A().alphaProductPlusY(-1.0, x, res1);
+
+  res4 = model->c();
+  model->A().alphaProductPlusY(-1.0, y, res4, true);
+
+  // ===================================================================================
+  // Second pass: complete res4 and compute the complementarity products
+  // ===================================================================================
+  double inf_norm_res4 = 0.0;
+  double min_prod = std::numeric_limits<double>::max();
+  double max_prod = 0.0;
+  int num_small = 0;
+  int num_large = 0;
+
+  for (int i = 0; i < n; ++i) {
     if (model->hasLb(i)) {
+      res4[i] -= zl[i];
       double prod = xl[i] * zl[i] / mu;
       min_prod = std::min(min_prod, prod);
       max_prod = std::max(max_prod, prod);
@@ -102,14 +210,27 @@ void IpmIterate::products() {
       if (prod > kLargeProduct) ++num_large;
     }
     if (model->hasUb(i)) {
+      res4[i] += zu[i];
       double prod = xu[i] * zu[i] / mu;
       min_prod = std::min(min_prod, prod);
       max_prod = std::max(max_prod, prod);
       if (prod < kSmallProduct) ++num_small;
       if (prod > kLargeProduct) ++num_large;
     }
+    inf_norm_res4 = std::max(inf_norm_res4, std::abs(res4[i]));
   }
 
+  // ===================================================================================
+  // Indicators
+  // ===================================================================================
+  pobj = model->objective(cx);
+  dobj = model->objective(dotProd(y, model->b()) + bound_terms);
+  pdGap();
+
+  pinf = std::max(infNorm(res1), inf_norm_res23);
+  pinf /= (1 + model->normScaledRhs());
+  dinf = inf_norm_res4 / (1 + model->normScaledObj());
+
   DataCollector::get()->back().min_prod = min_prod;
   DataCollector::get()->back().max_prod = max_prod;
   DataCollector::get()->back().num_small_prod = num_small;
@@ -126,14 +247,15 @@ void IpmIterate::indicators() {
 }
 
 void IpmIterate::primalObj() {
-  pobj = model->offset() + dotProd(x, model->c());
+  pobj = model->objective(dotProd(x, model->c()));
 }
 void IpmIterate::dualObj() {
-  dobj = model->offset() + dotProd(y, model->b());
+  double scaled_dobj = dotProd(y, model->b());
   for (int i = 0; i < model->n(); ++i) {
-    if (model->hasLb(i)) dobj += model->lb(i) * zl[i];
-    if (model->hasUb(i)) dobj -= model->ub(i) * zu[i];
+    if (model->hasLb(i)) scaled_dobj += model->lb(i) * zl[i];
+    if (model->hasUb(i)) scaled_dobj -= model->ub(i) * zu[i];
   }
+  dobj = model->objective(scaled_dobj);
 }
 void IpmIterate::pdGap() {
   // relative primal-dual gap
@@ -168,6 +290,7 @@ void IpmIterate::primalInfeasUnscaled() {
     if (model->scaled()) val *= model->colScale(i);
     pinf = std::max(pinf, val);
   }
+  pinf /= model->boundScale();
   pinf /= (1.0 + model->normUnscaledRhs());
 }
 void IpmIterate::dualInfeasUnscaled() {
@@ -178,6 +301,7 @@ void IpmIterate::dualInfeasUnscaled() {
     if (model->scaled()) val /= model->colScale(i);
     dinf = std::max(dinf, val);
   }
+  dinf /= model->costScale();
   dinf /= (1.0 + model->normUnscaledObj());
 }
 
@@ -211,42 +335,35 @@ void IpmIterate::residual1234() {
   }
 }
 void IpmIterate::residual56(double sigma) {
-  for (int i = 0; i < model->n(); ++i) {
-    // res5
-    if (model->hasLb(i))
-      res5[i] = sigma * mu - xl[i] * zl[i];
-    else
-      res5[i] = 0.0;
-
-    // res6
-    if (model->hasUb(i))
-      res6[i] = sigma * mu - xu[i] * zu[i];
-    else
-      res6[i] = 0.0;
+  const double* lbm = model->lbMask().data();
+  const double* ubm = model->ubMask().data();
+  const int n = model->n();
+  const double target = sigma * mu;
+
+  for (int i = 0; i < n; ++i) {
+    res5[i] = lbm[i] * (target - xl[i] * zl[i]);
+    res6[i] = ubm[i] * (target - xu[i] * zu[i]);
   }
 }
 
-std::vector<double> IpmIterate::residual7() const {
-  std::vector<double> res7(res4);
-  for (int i = 0; i < model->n(); ++i) {
-    if (model->hasLb(i)) res7[i] -= ((res5[i] + zl[i] * res2[i]) / xl[i]);
-    if (model->hasUb(i)) res7[i] += ((res6[i] - zu[i] * res3[i]) / xu[i]);
-  }
-  return res7;
+void IpmIterate::residual7(std::vector<double>& res7) const {
+  res7 = res4;
+  for (int i : model->lbIndex())
+    res7[i] -= ((res5[i] + zl[i] * res2[i]) / xl[i]);
+  for (int i : model->ubIndex())
+    res7[i] += ((res6[i] - zu[i] * res3[i]) / xu[i]);
 }
-std::vector<double> IpmIterate::residual8(
-    const std::vector<double>& res7) const {
-  std::vector<double> res8(res1);
-  std::vector<double> temp(res7);
+void IpmIterate::residual8(const std::vector<double>& res7,
+                           std::vector<double>& res8,
+                           std::vector<double>& temp) const {
+  res8 = res1;
 
   // temp = (Theta^-1+Rp)^-1 * res7
   for (int i = 0; i < model->n(); ++i)
-    temp[i] /= scaling[i] + kPrimalStaticRegularization;
+    temp[i] = res7[i] / (scaling[i] + kPrimalStaticRegularization);
 
   // res8 += A * temp
   model->A().alphaProductPlusY(1.0, temp, res8);
-
-  return res8;
 }
 
 void IpmIterate::clearIter() {
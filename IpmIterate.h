@@ -17,6 +17,39 @@ struct NewtonDir {
   NewtonDir(int m, int n);
 };
 
+// Holds the temporary vectors used during the ipm iterations. It is sized once,
+// before the iterations start, so that no memory is allocated afterwards.
+struct IpmWorkspace {
+  // residuals of the reduced Newton systems
+  std::vector<double> res7{};
+  std::vector<double> res8{};
+
+  // Theta * res7, used to compute res8
+  std::vector<double> theta_res7{};
+
+  // A^T * Deltay, used to recover the direction
+  std::vector<double> Atdy{};
+
+  // trial point, used to compute the rhs of the correctors
+  std::vector<double> xlt{}, xut{}, zlt{}, zut{};
+
+  // corrector direction
+  NewtonDir corr;
+
+  // residuals of the six blocks of the Newton system and products with |A|,
+  // used to compute the backward error
+  std::vector<double> r1{}, r2{}, r3{}, r4{}, r5{}, r6{};
+  std::vector<double> abs_prod_A{}, abs_prod_At{};
+
+  // partial results of each chunk in the ratio tests: the minimum ratio and
+  // blocking index of stepToBoundary, or up to four (value, slope) pairs of
+  // bestWeight
+  std::vector<double> chunk_ratio{};
+  std::vector<int> chunk_block{};
+
+  IpmWorkspace(int m, int n);
+};
+
 struct IpmIterate {
   // lp model
   const IpmModel* model;
@@ -93,6 +126,18 @@ struct IpmIterate {
   // complementarity products
   void products();
 
+  // ===================================================================================
+  // Make a step along delta with stepsizes alpha_p, alpha_d and compute the new
+  // residuals 1-4, mu and the indicators. Equivalent to updating each vector
+  // and calling residual1234, computeMu and indicators, but it streams through
+  // the vectors of length n only twice:
+  // - the first pass updates x, xl, xu, zl, zu and computes res2, res3, mu and
+  //   the terms of the objectives that depend only on the columns;
+  // - the second pass, after the products with A, completes res4 and computes
+  //   the complementarity products.
+  // ===================================================================================
+  void step(double alpha_p, double alpha_d);
+
   // ===================================================================================
   // Compute:
   //  res1 = rhs - A * x
@@ -119,13 +164,15 @@ struct IpmIterate {
   // (the computation of res7 takes into account only the components for which
   // the correspoding upper/lower bounds are finite)
   // ===================================================================================
-  std::vector<double> residual7() const;
+  void residual7(std::vector<double>& res7) const;
 
   // ===================================================================================
   // Compute:
   //  res8 = res1 + A * Theta * res7
+  // using temp as workspace of size n.
   // ===================================================================================
-  std::vector<double> residual8(const std::vector<double>& res7) const;
+  void residual8(const std::vector<double>& res7, std::vector<double>& res8,
+                 std::vector<double>& temp) const;
 
   // ===================================================================================
   // Extract solution to be returned to user:
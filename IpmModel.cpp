@@ -1,52 +1,151 @@
 #include "IpmModel.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+// copy size entries into a vector with capacity for spare more
+template <typename T>
+static std::vector<T> copyWithSpare(const T* data, int size, int spare) {
+  std::vector<T> v;
+  v.reserve(size + spare);
+  v.assign(data, data + size);
+  return v;
+}
+
 void IpmModel::init(const int num_var, const int num_con, const double* obj,
                     const double* rhs, const double* lower, const double* upper,
                     const int* A_ptr, const int* A_rows, const double* A_vals,
                     const char* constraints, double offset,
-                    const std::string& pb_name) {
-  // copy the input into the model
+                    const std::string& pb_name, const Options& options) {
+  // copy the input and adopt the copies, leaving space for the slacks added
+  // by reformulate, so that the copies are not reallocated
+
+  int Annz = A_ptr[num_var];
+  init(num_var, num_con, copyWithSpare(obj, num_var, num_con),
+       std::vector<double>(rhs, rhs + num_con),
+       copyWithSpare(lower, num_var, num_con),
+       copyWithSpare(upper, num_var, num_con),
+       copyWithSpare(A_ptr, num_var + 1, num_con),
+       copyWithSpare(A_rows, Annz, num_con),
+       copyWithSpare(A_vals, Annz, num_con),
+       std::vector<char>(constraints, constraints + num_con), offset, pb_name,
+       options);
+}
+
+void IpmModel::init(const int num_var, const int num_con,
+                    std::vector<double>&& obj, std::vector<double>&& rhs,
+                    std::vector<double>&& lower, std::vector<double>&& upper,
+                    std::vector<int>&& A_ptr, std::vector<int>&& A_rows,
+                    std::vector<double>&& A_vals,
+                    std::vector<char>&& constraints, double offset,
+                    const std::string& pb_name, const Options& options) {
+  // adopt the input into the model, without copying it. The original problem
+  // is not stored: it is recovered from the scaled one when needed.
 
   num_var_ = num_var;
   num_con_ = num_con;
-  c_orig_ = obj;
-  b_orig_ = rhs;
-  lower_orig_ = lower;
-  upper_orig_ = upper;
-  A_ptr_orig_ = A_ptr;
-  A_rows_orig_ = A_rows;
-  A_vals_orig_ = A_vals;
-  constraints_orig_ = constraints;
   offset_ = offset;
 
   n_ = num_var;
   m_ = num_con;
-  c_ = std::vector<double>(obj, obj + n_);
-  b_ = std::vector<double>(rhs, rhs + m_);
-  lower_ = std::vector<double>(lower, lower + n_);
-  upper_ = std::vector<double>(upper, upper + n_);
+  c_ = std::move(obj);
+  b_ = std::move(rhs);
+  lower_ = std::move(lower);
+  upper_ = std::move(upper);
 
-  int Annz = A_ptr[n_];
   A_.num_col_ = n_;
   A_.num_row_ = m_;
-  A_.start_ = std::vector<int>(A_ptr, A_ptr + n_ + 1);
-  A_.index_ = std::vector<int>(A_rows, A_rows + Annz);
-  A_.value_ = std::vector<double>(A_vals, A_vals + Annz);
+  A_.start_ = std::move(A_ptr);
+  A_.index_ = std::move(A_rows);
+  A_.value_ = std::move(A_vals);
 
-  constraints_ = std::vector<char>(constraints, constraints + m_);
+  constraints_ = std::move(constraints);
 
   pb_name_ = pb_name;
 
-  scale();
+  computeRanges(ranges_orig_);
+
+  scale(options);
+  if (options.scale_obj == kOptionScaleObjOn) scaleObjBounds();
   reformulate();
+  computeMasks();
 
   ready_ = true;
 }
 
+void IpmModel::update(const double* obj, const double* rhs,
+                      const double* lower, const double* upper) {
+  // Only the original variables and constraints are updated. The bounds of the
+  // slacks depend only on the type of constraints, which does not change. The
+  // scaling computed in init is applied also to the new data.
+
+  if (obj) {
+    for (int i = 0; i < num_var_; ++i)
+      c_[i] = (scaled() ? obj[i] * colscale_[i] : obj[i]) * cost_scale_;
+  }
+  if (lower) {
+    for (int i = 0; i < num_var_; ++i)
+      lower_[i] =
+          (scaled() ? lower[i] / colscale_[i] : lower[i]) * bound_scale_;
+  }
+  if (upper) {
+    for (int i = 0; i < num_var_; ++i)
+      upper_[i] =
+          (scaled() ? upper[i] / colscale_[i] : upper[i]) * bound_scale_;
+  }
+  if (rhs) {
+    for (int i = 0; i < m_; ++i)
+      b_[i] = (scaled() ? rhs[i] * rowscale_[i] : rhs[i]) * bound_scale_;
+  }
+
+  // bounds may have become finite or infinite
+  computeMasks();
+}
+
+void IpmModel::computeMasks() {
+  lb_mask_.resize(n_);
+  ub_mask_.resize(n_);
+  lb_index_.clear();
+  ub_index_.clear();
+  bnd_index_.clear();
+  free_index_.clear();
+  for (int i = 0; i < n_; ++i) {
+    lb_mask_[i] = std::isfinite(lower_[i]) ? 1.0 : 0.0;
+    ub_mask_[i] = std::isfinite(upper_[i]) ? 1.0 : 0.0;
+    if (lb_mask_[i] != 0.0) lb_index_.push_back(i);
+    if (ub_mask_[i] != 0.0) ub_index_.push_back(i);
+    if (lb_mask_[i] != 0.0 || ub_mask_[i] != 0.0)
+      bnd_index_.push_back(i);
+    else
+      free_index_.push_back(i);
+  }
+  num_finite_bounds_ = lb_index_.size() + ub_index_.size();
+}
+
 void IpmModel::reformulate() {
   // put the model into correct formulation
 
-  int Annz = A_.numNz();
+  // reserve space for the slacks, so that the vectors are not reallocated
+  // while they grow. If the input already has enough capacity (see
+  // Ipm::load), this does not copy anything.
+  int num_slacks = 0;
+  for (int i = 0; i < m_; ++i)
+    if (constraints_[i] != '=') ++num_slacks;
+
+  const int new_n = n_ + num_slacks;
+  lower_.reserve(new_n);
+  upper_.reserve(new_n);
+  c_.reserve(new_n);
+  if (scaled()) colscale_.reserve(new_n);
+  A_.start_.reserve(new_n + 1);
+  A_.index_.reserve(A_.numNz() + num_slacks);
+  A_.value_.reserve(A_.numNz() + num_slacks);
 
   for (int i = 0; i < m_; ++i) {
     if (constraints_[i] != '=') {
@@ -77,11 +176,14 @@ void IpmModel::reformulate() {
   }
 }
 
-void IpmModel::checkCoefficients() const {
+void IpmModel::computeRanges(CoeffRanges& ranges) const {
+  // Only the original variables are considered, so that the ranges before
+  // and after reformulating the problem can be compared.
+
   // compute max and min entry of A in absolute value
   double Amin = kHighsInf;
   double Amax = 0.0;
-  for (int col = 0; col < A_.num_col_; ++col) {
+  for (int col = 0; col < num_var_; ++col) {
     for (int el = A_.start_[col]; el < A_.start_[col + 1]; ++el) {
       double val = std::abs(A_.value_[el]);
       if (val != 0.0) {
@@ -95,7 +197,7 @@ void IpmModel::checkCoefficients() const {
   // compute max and min entry of c
   double cmin = kHighsInf;
   double cmax = 0.0;
-  for (int i = 0; i < n_; ++i) {
+  for (int i = 0; i < num_var_; ++i) {
     if (c_[i] != 0.0) {
       cmin = std::min(cmin, std::abs(c_[i]));
       cmax = std::max(cmax, std::abs(c_[i]));
@@ -117,7 +219,7 @@ void IpmModel::checkCoefficients() const {
   // compute max and min for bounds
   double boundmin = kHighsInf;
   double boundmax = 0.0;
-  for (int i = 0; i < n_; ++i) {
+  for (int i = 0; i < num_var_; ++i) {
     if (lower_[i] != 0.0 && std::isfinite(lower_[i])) {
       boundmin = std::min(boundmin, std::abs(lower_[i]));
       boundmax = std::max(boundmax, std::abs(lower_[i]));
@@ -129,6 +231,23 @@ void IpmModel::checkCoefficients() const {
   }
   if (std::isinf(boundmin)) boundmin = 0.0;
 
+  ranges = {Amin, Amax, bmin, bmax, cmin, cmax, boundmin, boundmax};
+}
+
+static void printRange(const char* name, double min, double max,
+                       double scaled_min, double scaled_max) {
+  printf("Range of %-7s : [%5.1e, %5.1e], ratio ", name, min, max);
+  min == 0.0 ? printf("%-8s", "-") : printf("%.1e ", max / min);
+  printf("-> [%5.1e, %5.1e], ratio ", scaled_min, scaled_max);
+  scaled_min == 0.0 ? printf("-\n")
+                    : printf("%.1e\n", scaled_max / scaled_min);
+}
+
+void IpmModel::checkCoefficients() const {
+  CoeffRanges sc;
+  computeRanges(sc);
+  const CoeffRanges& og = ranges_orig_;
+
   // compute max and min scaling
   double scalemin = kHighsInf;
   double scalemax = 0.0;
@@ -144,23 +263,25 @@ void IpmModel::checkCoefficients() const {
   }
   if (std::isinf(scalemin)) scalemin = 0.0;
 
-  // print ranges
-  printf("Range of A      : [%5.1e, %5.1e], ratio ", Amin, Amax);
-  Amin == 0.0 ? printf("-\n") : printf("%.1e\n", Amax / Amin);
-  printf("Range of b      : [%5.1e, %5.1e], ratio ", bmin, bmax);
-  bmin == 0.0 ? printf("-\n") : printf("%.1e\n", bmax / bmin);
-  printf("Range of c      : [%5.1e, %5.1e], ratio ", cmin, cmax);
-  cmin == 0.0 ? printf("-\n") : printf("%.1e\n", cmax / cmin);
-  printf("Range of bounds : [%5.1e, %5.1e], ratio ", boundmin, boundmax);
-  boundmin == 0.0 ? printf("-\n") : printf("%.1e\n", boundmax / boundmin);
-  printf("Scaling coeff   : ");
+  // print ranges, original -> scaled
+  printRange("A", og.Amin, og.Amax, sc.Amin, sc.Amax);
+  printRange("b", og.bmin, og.bmax, sc.bmin, sc.bmax);
+  printRange("c", og.cmin, og.cmax, sc.cmin, sc.cmax);
+  printRange("bounds", og.boundmin, og.boundmax, sc.boundmin, sc.boundmax);
+  printf("Scaling coeff    : ");
   scaled() ? printf("[%5.1e, %5.1e], ratio %.1e\n", scalemin, scalemax,
                     scalemax / scalemin)
            : printf("-\n");
+  if (cost_scale_ != 1.0 || bound_scale_ != 1.0)
+    printf("Cost scaling %.1e, bound scaling %.1e\n", cost_scale_,
+           bound_scale_);
 }
 
-void IpmModel::scale() {
-  // Apply Curtis-Reid scaling and scale the problem accordingly
+void IpmModel::scale(const Options& options) {
+  // Scale the matrix with the method chosen and scale the problem
+  // accordingly
+
+  if (options.scaling == kOptionScalingNone) return;
 
   // check if scaling is needed
   bool need_scaling = false;
@@ -187,10 +308,20 @@ void IpmModel::scale() {
   // z -> C * z
   // where R is row scaling, C is col scaling.
 
-  // Compute exponents for CR scaling of matrix A
+  // Compute exponents for scaling of matrix A
   std::vector<int> colexp(n_);
   std::vector<int> rowexp(m_);
-  CurtisReidScaling(A_.start_, A_.index_, A_.value_, rowexp, colexp);
+  switch (options.scaling) {
+    case kOptionScalingCR:
+      CurtisReidScaling(A_.start_, A_.index_, A_.value_, rowexp, colexp);
+      break;
+    case kOptionScalingGeometric:
+      GeometricMeanScaling(A_.start_, A_.index_, A_.value_, rowexp, colexp);
+      break;
+    case kOptionScalingRuiz:
+      RuizScaling(A_.start_, A_.index_, A_.value_, rowexp, colexp);
+      break;
+  }
 
   // Compute scaling from exponents
   colscale_.resize(n_);
@@ -223,6 +354,37 @@ void IpmModel::scale() {
   }
 }
 
+void IpmModel::scaleObjBounds() {
+  // Scale the cost vector so that its largest entry is close to one, and the
+  // rhs and bounds so that their largest entry is close to one. Powers of 2
+  // are used, so that the scaling is exact.
+  // Transformation:
+  // c -> cs * c
+  // b -> bs * b
+  // bounds -> bs * bounds
+  // x -> bs * x
+  // y -> cs * y
+  // z -> cs * z
+
+  double norm_obj = infNorm(c_);
+  double norm_rhs = normScaledRhs();
+
+  int exp;
+  if (norm_obj > 0.0 && std::isfinite(norm_obj)) {
+    std::frexp(norm_obj, &exp);
+    cost_scale_ = std::ldexp(1.0, -exp);
+  }
+  if (norm_rhs > 0.0 && std::isfinite(norm_rhs)) {
+    std::frexp(norm_rhs, &exp);
+    bound_scale_ = std::ldexp(1.0, -exp);
+  }
+
+  for (double& d : c_) d *= cost_scale_;
+  for (double& d : b_) d *= bound_scale_;
+  for (double& d : lower_) d *= bound_scale_;
+  for (double& d : upper_) d *= bound_scale_;
+}
+
 void IpmModel::unscale(std::vector<double>& x, std::vector<double>& xl,
                        std::vector<double>& xu, std::vector<double>& slack,
                        std::vector<double>& y, std::vector<double>& zl,
@@ -242,6 +404,13 @@ void IpmModel::unscale(std::vector<double>& x, std::vector<double>& xl,
       slack[i] /= rowscale_[i];
     }
   }
+  unscaleObjBounds(x, slack, y);
+  for (int i = 0; i < num_var_; ++i) {
+    xl[i] /= bound_scale_;
+    xu[i] /= bound_scale_;
+    zl[i] /= cost_scale_;
+    zu[i] /= cost_scale_;
+  }
 
   // set variables that were ignored
   for (int i = 0; i < num_var_; ++i) {
@@ -270,6 +439,19 @@ void IpmModel::unscale(std::vector<double>& x, std::vector<double>& slack,
       slack[i] /= rowscale_[i];
     }
   }
+  unscaleObjBounds(x, slack, y);
+  for (int i = 0; i < num_var_; ++i) z[i] /= cost_scale_;
+}
+
+void IpmModel::unscaleObjBounds(std::vector<double>& x,
+                                std::vector<double>& slack,
+                                std::vector<double>& y) const {
+  if (cost_scale_ == 1.0 && bound_scale_ == 1.0) return;
+  for (int i = 0; i < num_var_; ++i) x[i] /= bound_scale_;
+  for (int i = 0; i < m_; ++i) {
+    y[i] /= cost_scale_;
+    slack[i] /= bound_scale_;
+  }
 }
 
 double IpmModel::normScaledRhs() const {
@@ -290,7 +472,7 @@ double IpmModel::normUnscaledObj() const {
     if (scaled()) val /= colscale_[i];
     norm_obj = std::max(norm_obj, val);
   }
-  return norm_obj;
+  return norm_obj / cost_scale_;
 }
 
 double IpmModel::normUnscaledRhs() const {
@@ -312,13 +494,226 @@ double IpmModel::normUnscaledRhs() const {
       norm_rhs = std::max(norm_rhs, val);
     }
   }
-  return norm_rhs;
+  return norm_rhs / bound_scale_;
 }
 
 int IpmModel::loadIntoIpx(ipx::LpSolver& lps) const {
+  // Recover the original problem from the scaled one. All the scaling factors
+  // are powers of 2, so this is exact. The slacks are the last columns of A_
+  // and are left out.
+
+  const int Annz = A_.start_[num_var_];
+  std::vector<double> obj(c_.begin(), c_.begin() + num_var_);
+  std::vector<double> rhs(b_);
+  std::vector<double> lower(lower_.begin(), lower_.begin() + num_var_);
+  std::vector<double> upper(upper_.begin(), upper_.begin() + num_var_);
+  std::vector<double> A_vals(A_.value_.begin(), A_.value_.begin() + Annz);
+
+  for (int i = 0; i < num_var_; ++i) {
+    obj[i] /= cost_scale_;
+    lower[i] /= bound_scale_;
+    upper[i] /= bound_scale_;
+  }
+  for (double& d : rhs) d /= bound_scale_;
+
+  if (scaled()) {
+    for (int col = 0; col < num_var_; ++col) {
+      obj[col] /= colscale_[col];
+      lower[col] *= colscale_[col];
+      upper[col] *= colscale_[col];
+      for (int el = A_.start_[col]; el < A_.start_[col + 1]; ++el) {
+        A_vals[el] /= rowscale_[A_.index_[el]];
+        A_vals[el] /= colscale_[col];
+      }
+    }
+    for (int row = 0; row < m_; ++row) rhs[row] /= rowscale_[row];
+  }
+
   int load_status = lps.LoadModel(
-      num_var_, offset_, c_orig_, lower_orig_, upper_orig_, num_con_,
-      A_ptr_orig_, A_rows_orig_, A_vals_orig_, b_orig_, constraints_orig_);
+      num_var_, offset_, obj.data(), lower.data(), upper.data(), num_con_,
+      A_.start_.data(), A_.index_.data(), A_vals.data(), rhs.data(),
+      constraints_.data());
 
   return load_status;
-}
\ No newline at end of file
+}
+
+// identifies files written by writeSnapshot, and their version
+const uint64_t kSnapshotMagic = 0x3130504E53495049ULL;  // "IPISNP01"
+
+// Fixed-size header of a snapshot, followed by the arrays:
+//  double: c, lower, upper (n), b (m), A values (nnz), colscale (n if
+//          scaled), rowscale (m if scaled)
+//  int:    A start (n + 1), A index (nnz)
+//  char:   constraints (m), problem name (name_len)
+// The header has a size multiple of 8, so that the arrays of doubles are
+// aligned when the file is mapped into memory.
+struct SnapshotHeader {
+  uint64_t magic;
+  int64_t num_var, num_con, n, m, nnz, scaled, name_len;
+  double offset, cost_scale, bound_scale;
+  double ranges[8];
+};
+
+static int64_t snapshotSize(const SnapshotHeader& h) {
+  int64_t num_double = 3 * h.n + h.m + h.nnz + (h.scaled ? h.n + h.m : 0);
+  int64_t num_int = h.n + 1 + h.nnz;
+  int64_t num_char = h.m + h.name_len;
+  return sizeof(SnapshotHeader) + num_double * sizeof(double) +
+         num_int * sizeof(int) + num_char;
+}
+
+bool IpmModel::writeSnapshot(const std::string& file_name) const {
+  if (!ready_) return false;
+
+  SnapshotHeader h{};
+  h.magic = kSnapshotMagic;
+  h.num_var = num_var_;
+  h.num_con = num_con_;
+  h.n = n_;
+  h.m = m_;
+  h.nnz = A_.numNz();
+  h.scaled = scaled();
+  h.name_len = pb_name_.size();
+  h.offset = offset_;
+  h.cost_scale = cost_scale_;
+  h.bound_scale = bound_scale_;
+  memcpy(h.ranges, &ranges_orig_, sizeof(h.ranges));
+
+  // write to a temporary file and rename it, so that a concurrent run never
+  // reads a partial snapshot
+  std::string temp_name = file_name + ".tmp";
+  {
+    std::ofstream file(temp_name, std::ios::binary);
+    if (!file) return false;
+
+    auto write = [&](const void* data, size_t size) {
+      file.write((const char*)data, size);
+    };
+    write(&h, sizeof(h));
+    write(c_.data(), n_ * sizeof(double));
+    write(lower_.data(), n_ * sizeof(double));
+    write(upper_.data(), n_ * sizeof(double));
+    write(b_.data(), m_ * sizeof(double));
+    write(A_.value_.data(), h.nnz * sizeof(double));
+    if (scaled()) {
+      write(colscale_.data(), n_ * sizeof(double));
+      write(rowscale_.data(), m_ * sizeof(double));
+    }
+    write(A_.start_.data(), (n_ + 1) * sizeof(int));
+    write(A_.index_.data(), h.nnz * sizeof(int));
+    write(constraints_.data(), m_);
+    write(pb_name_.data(), h.name_len);
+    if (!file) return false;
+  }
+
+  return std::rename(temp_name.c_str(), file_name.c_str()) == 0;
+}
+
+bool IpmModel::readSnapshot(const std::string& file_name) {
+  ready_ = false;
+
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) || st.st_size < (off_t)sizeof(SnapshotHeader)) {
+    close(fd);
+    return false;
+  }
+
+  // map the whole file and copy the arrays straight out of the page cache
+  void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+
+  const char* ptr = static_cast<const char*>(map);
+  SnapshotHeader h;
+  memcpy(&h, ptr, sizeof(h));
+  ptr += sizeof(h);
+
+  // check the header before using it to compute the size, so that the size
+  // cannot overflow
+  const int64_t max_int = std::numeric_limits<int>::max();
+  if (h.magic != kSnapshotMagic || h.num_var < 0 || h.num_con < 0 ||
+      h.n < h.num_var || h.n - h.num_var > h.num_con || h.n >= max_int ||
+      h.m != h.num_con || h.m > max_int || h.nnz < 0 || h.nnz > max_int ||
+      (h.scaled != 0 && h.scaled != 1) || h.name_len < 0 ||
+      h.name_len > max_int || snapshotSize(h) != st.st_size) {
+    munmap(map, st.st_size);
+    return false;
+  }
+
+  // locate the arrays inside the mapping
+  auto next = [&](int64_t bytes) {
+    const char* data = ptr;
+    ptr += bytes;
+    return data;
+  };
+  const double* c = (const double*)next(h.n * sizeof(double));
+  const double* lower = (const double*)next(h.n * sizeof(double));
+  const double* upper = (const double*)next(h.n * sizeof(double));
+  const double* b = (const double*)next(h.m * sizeof(double));
+  const double* value = (const double*)next(h.nnz * sizeof(double));
+  const double* colscale = nullptr;
+  const double* rowscale = nullptr;
+  if (h.scaled) {
+    colscale = (const double*)next(h.n * sizeof(double));
+    rowscale = (const double*)next(h.m * sizeof(double));
+  }
+  const int* start = (const int*)next((h.n + 1) * sizeof(int));
+  const int* index = (const int*)next(h.nnz * sizeof(int));
+  const char* constraints = next(h.m);
+  const char* name = next(h.name_len);
+
+  // validate the arrays before modifying the model, so that a corrupt file
+  // leaves it untouched and cannot cause accesses out of bounds later
+  bool valid = start[0] == 0 && start[h.n] == h.nnz;
+  for (int64_t col = 0; valid && col < h.n; ++col)
+    valid = start[col] <= start[col + 1];
+  for (int64_t el = 0; valid && el < h.nnz; ++el)
+    valid = index[el] >= 0 && index[el] < h.m;
+  int64_t num_slacks = 0;
+  for (int64_t i = 0; valid && i < h.m; ++i) {
+    valid = constraints[i] == '=' || constraints[i] == '<' ||
+            constraints[i] == '>';
+    if (constraints[i] != '=') ++num_slacks;
+  }
+  if (!valid || num_slacks != h.n - h.num_var) {
+    munmap(map, st.st_size);
+    return false;
+  }
+
+  num_var_ = h.num_var;
+  num_con_ = h.num_con;
+  n_ = h.n;
+  m_ = h.m;
+  offset_ = h.offset;
+  cost_scale_ = h.cost_scale;
+  bound_scale_ = h.bound_scale;
+  memcpy(&ranges_orig_, h.ranges, sizeof(h.ranges));
+
+  c_.assign(c, c + n_);
+  lower_.assign(lower, lower + n_);
+  upper_.assign(upper, upper + n_);
+  b_.assign(b, b + m_);
+  colscale_.clear();
+  rowscale_.clear();
+  if (h.scaled) {
+    colscale_.assign(colscale, colscale + n_);
+    rowscale_.assign(rowscale, rowscale + m_);
+  }
+  A_.num_col_ = n_;
+  A_.num_row_ = m_;
+  A_.start_.assign(start, start + n_ + 1);
+  A_.index_.assign(index, index + h.nnz);
+  A_.value_.assign(value, value + h.nnz);
+  constraints_.assign(constraints, constraints + m_);
+  pb_name_.assign(name, h.name_len);
+
+  munmap(map, st.st_size);
+
+  computeMasks();
+  ready_ = true;
+
+  return true;
+}
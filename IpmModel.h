@@ -6,6 +6,8 @@
 #include <vector>
 
 #include "CurtisReidScaling.h"
+#include "EquilibrationScaling.h"
+#include "Ipm_const.h"
 #include "ipm/ipx/lp_solver.h"
 #include "util/HighsSparseMatrix.h"
 
@@ -24,17 +26,10 @@
 
 class IpmModel {
  private:
-  // data of original problem
+  // size of original problem. The data is not stored, only its scaled and
+  // reformulated version below.
   int num_var_{};
   int num_con_{};
-  const double* c_orig_;
-  const double* b_orig_;
-  const double* lower_orig_;
-  const double* upper_orig_;
-  const int* A_ptr_orig_;
-  const int* A_rows_orig_;
-  const double* A_vals_orig_;
-  const char* constraints_orig_;
   double offset_;
 
   // data of reformulated problem
@@ -54,20 +49,79 @@ class IpmModel {
   std::vector<double> colscale_{};
   std::vector<double> rowscale_{};
 
+  // scaling of the objective and of rhs and bounds, powers of 2
+  double cost_scale_ = 1.0;
+  double bound_scale_ = 1.0;
+
+  // Range of the coefficients of the problem, excluding slacks
+  struct CoeffRanges {
+    double Amin, Amax, bmin, bmax, cmin, cmax, boundmin, boundmax;
+  };
+
+  // ranges of the original problem, computed before scaling
+  CoeffRanges ranges_orig_{};
+
+  // 1.0 if the variable has a finite lower/upper bound, 0.0 otherwise.
+  // Computed once, so that the loops over the variables can use them without
+  // branching on std::isfinite.
+  std::vector<double> lb_mask_{};
+  std::vector<double> ub_mask_{};
+  int num_finite_bounds_{};
+
+  // indices of the variables with a finite lower/upper bound, in increasing
+  // order. Loops that only involve xl, zl or xu, zu run over these, skipping
+  // the entries of free or one-sided variables.
+  std::vector<int> lb_index_{};
+  std::vector<int> ub_index_{};
+
+  // indices of the variables with at least one finite bound, and of the free
+  // variables, in increasing order
+  std::vector<int> bnd_index_{};
+  std::vector<int> free_index_{};
+
   // Put the model into correct formulation
   void reformulate();
 
   // Scale the problem
-  void scale();
+  void scale(const Options& options);
+
+  // Scale the objective and rhs and bounds by powers of 2
+  void scaleObjBounds();
+
+  // Undo the scaling of objective and bounds on x, slack and y
+  void unscaleObjBounds(std::vector<double>& x, std::vector<double>& slack,
+                        std::vector<double>& y) const;
+
+  // Compute range of coefficients of the current data
+  void computeRanges(CoeffRanges& ranges) const;
+
+  // Compute the masks and index lists of finite bounds
+  void computeMasks();
 
  public:
-  // Initialize the model
+  // Initialize the model, copying the input
   void init(const int num_var, const int num_con, const double* obj,
             const double* rhs, const double* lower, const double* upper,
             const int* A_ptr, const int* A_rows, const double* A_vals,
-            const char* constraints, double offset, const std::string& pb_name);
-
-  // Compute range of coefficients
+            const char* constraints, double offset, const std::string& pb_name,
+            const Options& options);
+
+  // Initialize the model, adopting the input vectors without copying them
+  void init(const int num_var, const int num_con, std::vector<double>&& obj,
+            std::vector<double>&& rhs, std::vector<double>&& lower,
+            std::vector<double>&& upper, std::vector<int>&& A_ptr,
+            std::vector<int>&& A_rows, std::vector<double>&& A_vals,
+            std::vector<char>&& constraints, double offset,
+            const std::string& pb_name, const Options& options);
+
+  // Replace cost, rhs and bounds of the original variables and constraints.
+  // Arrays passed as nullptr are left unchanged. The new data is scaled with
+  // the existing scaling factors; the matrix and the type of constraints
+  // cannot change.
+  void update(const double* obj, const double* rhs, const double* lower,
+              const double* upper);
+
+  // Print range of coefficients, before and after scaling
   void checkCoefficients() const;
 
   // Unscale a given solution
@@ -84,8 +138,15 @@ class IpmModel {
   double normUnscaledObj() const;
 
   // Check if variable has finite lower/upper bound
-  bool hasLb(int j) const { return std::isfinite(lower_[j]); }
-  bool hasUb(int j) const { return std::isfinite(upper_[j]); }
+  bool hasLb(int j) const { return lb_mask_[j] != 0.0; }
+  bool hasUb(int j) const { return ub_mask_[j] != 0.0; }
+  const std::vector<double>& lbMask() const { return lb_mask_; }
+  const std::vector<double>& ubMask() const { return ub_mask_; }
+  int numFiniteBounds() const { return num_finite_bounds_; }
+  const std::vector<int>& lbIndex() const { return lb_index_; }
+  const std::vector<int>& ubIndex() const { return ub_index_; }
+  const std::vector<int>& bndIndex() const { return bnd_index_; }
+  const std::vector<int>& freeIndex() const { return free_index_; }
 
   int m() const { return m_; }
   int n() const { return n_; }
@@ -101,9 +162,25 @@ class IpmModel {
   double rowScale(int i) const { return rowscale_[i]; }
   bool ready() const { return ready_; }
   bool scaled() const { return colscale_.size() > 0; }
+  double costScale() const { return cost_scale_; }
+  double boundScale() const { return bound_scale_; }
   double offset() const { return offset_; }
 
+  // Value of the original objective, given the scaled one without offset
+  double objective(double scaled_obj) const {
+    return offset_ + scaled_obj / (cost_scale_ * bound_scale_);
+  }
+
   int loadIntoIpx(ipx::LpSolver& lps) const;
+
+  // Write the scaled and reformulated model to a binary file, and read it
+  // back, skipping reading, presolve and scaling. The file is mapped into
+  // memory only to read it: the arrays are validated and copied into the
+  // model, and the mapping is released. Return false if the file could not be
+  // written or is not a valid snapshot; in that case the model is unchanged,
+  // but not ready.
+  bool writeSnapshot(const std::string& file_name) const;
+  bool readSnapshot(const std::string& file_name);
 };
 
 #endif
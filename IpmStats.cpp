@@ -0,0 +1,111 @@
+#include "IpmStats.h"
+
+#include <cstdio>
+
+#include "Ipm_const.h"
+
+void IpmStats::clear() {
+  for (int i = 0; i < kPhaseNum; ++i) {
+    phase_[i] = PhaseStats{};
+    prev_time_[i] = 0.0;
+    prev_calls_[i] = 0;
+  }
+  // space for all the iterations, so that endIter does not allocate
+  iters_.clear();
+  iters_.reserve(kMaxIterations);
+  active_ = -1;
+  iter_start_ = clock::now();
+}
+
+void IpmStats::accumulate(clock::time_point now) {
+  if (active_ >= 0)
+    phase_[active_].time += std::chrono::duration<double>(now - since_).count();
+  since_ = now;
+}
+
+int IpmStats::enter(IpmPhase phase, double bytes) {
+  accumulate(clock::now());
+  int previous = active_;
+  active_ = phase;
+  ++phase_[phase].calls;
+  phase_[phase].bytes += bytes;
+  return previous;
+}
+
+void IpmStats::leave(int previous) {
+  accumulate(clock::now());
+  active_ = previous;
+}
+
+void IpmStats::endIter(int iter) {
+  clock::time_point now = clock::now();
+  accumulate(now);
+
+  IterStats record;
+  record.iter = iter;
+  record.time = std::chrono::duration<double>(now - iter_start_).count();
+  for (int i = 0; i < kPhaseNum; ++i) {
+    record.phase_time[i] = phase_[i].time - prev_time_[i];
+    prev_time_[i] = phase_[i].time;
+    record.phase_calls[i] = phase_[i].calls - prev_calls_[i];
+    prev_calls_[i] = phase_[i].calls;
+  }
+  iters_.push_back(record);
+
+  iter_start_ = now;
+}
+
+double IpmStats::totalTime() const {
+  double total = 0.0;
+  for (int i = 0; i < kPhaseNum; ++i) total += phase_[i].time;
+  return total;
+}
+
+const char* IpmStats::phaseName(IpmPhase phase) {
+  switch (phase) {
+    case kPhaseAnalyse:
+      return "Analyse";
+    case kPhaseFactorise:
+      return "Factorise";
+    case kPhaseSolve:
+      return "Solve";
+    case kPhaseRefine:
+      return "Refine";
+    case kPhaseStartingPoint:
+      return "Starting point";
+    case kPhaseScaling:
+      return "Scaling";
+    case kPhaseResiduals:
+      return "Residuals";
+    case kPhaseRecoverDirection:
+      return "Recover direction";
+    case kPhaseStepSizes:
+      return "Step sizes";
+    case kPhaseStep:
+      return "Step";
+    case kPhaseCorrectors:
+      return "Correctors";
+    case kPhaseBackwardError:
+      return "Backward error";
+    default:
+      return "";
+  }
+}
+
+void IpmStats::print() const {
+  double total = totalTime();
+  if (total <= 0.0) return;
+
+  printf("\nIpm phases\n");
+  printf("%-18s %10s %6s %10s %10s\n", "", "time", "%", "calls", "GB/s");
+  for (int i = 0; i < kPhaseNum; ++i) {
+    const PhaseStats& ps = phase_[i];
+    if (ps.calls == 0) continue;
+    printf("%-18s %10.3f %6.1f %10lld ", phaseName((IpmPhase)i), ps.time,
+           100.0 * ps.time / total, ps.calls);
+    if (ps.bytes > 0.0 && ps.time > 0.0)
+      printf("%10.2f\n", ps.bytes / ps.time * 1e-9);
+    else
+      printf("%10s\n", "-");
+  }
+}
@@ -0,0 +1,108 @@
+#ifndef IPM_STATS_H
+#define IPM_STATS_H
+
+#include <chrono>
+#include <vector>
+
+// Instrumentation of the ipm: cumulative time, number of calls and estimate
+// of the bytes touched by each phase, and a record for each iteration.
+//
+// Time is exclusive: when a phase is entered while another one is active,
+// the outer phase is paused, so that the times of all phases add up to the
+// time spent inside any of them. Time not spent in any phase is reported as
+// other.
+//
+// Compiling with IPM_NO_STATS removes all the timers, so that they cost
+// nothing; the statistics are then all zero.
+
+enum IpmPhase {
+  kPhaseAnalyse = 0,
+  kPhaseFactorise,
+  kPhaseSolve,
+  kPhaseRefine,
+  kPhaseStartingPoint,
+  kPhaseScaling,
+  kPhaseResiduals,
+  kPhaseRecoverDirection,
+  kPhaseStepSizes,
+  kPhaseStep,
+  kPhaseCorrectors,
+  kPhaseBackwardError,
+  kPhaseNum
+};
+
+struct PhaseStats {
+  double time{};
+  long long calls{};
+  double bytes{};
+};
+
+struct IterStats {
+  int iter{};
+  double time{};
+  double phase_time[kPhaseNum]{};
+  long long phase_calls[kPhaseNum]{};
+};
+
+class IpmStats {
+  using clock = std::chrono::steady_clock;
+
+  PhaseStats phase_[kPhaseNum]{};
+  std::vector<IterStats> iters_{};
+
+  // phase currently active, or -1, and when it was last resumed
+  int active_ = -1;
+  clock::time_point since_{};
+
+  // cumulative times and calls at the end of the previous iteration
+  clock::time_point iter_start_{};
+  double prev_time_[kPhaseNum]{};
+  long long prev_calls_[kPhaseNum]{};
+
+  void accumulate(clock::time_point now);
+
+ public:
+  // Reset all the statistics
+  void clear();
+
+  // Enter a phase and return the phase that was active, to be passed to leave
+  int enter(IpmPhase phase, double bytes);
+  void leave(int previous);
+
+  // Close the record of the current iteration
+  void endIter(int iter);
+
+  const PhaseStats& phase(IpmPhase phase) const { return phase_[phase]; }
+  const std::vector<IterStats>& iters() const { return iters_; }
+
+  // Sum of the times of all phases
+  double totalTime() const;
+
+  static const char* phaseName(IpmPhase phase);
+
+  void print() const;
+};
+
+// Time the enclosing scope as the given phase
+class PhaseTimer {
+  IpmStats& stats_;
+  int previous_;
+
+ public:
+  PhaseTimer(IpmStats& stats, IpmPhase phase, double bytes = 0.0)
+      : stats_(stats), previous_(stats.enter(phase, bytes)) {}
+  ~PhaseTimer() { stats_.leave(previous_); }
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+};
+
+#ifndef IPM_NO_STATS
+#define IPM_TIME_PHASE(stats, phase, bytes) \
+  PhaseTimer phase_timer(stats, phase, bytes)
+#define IPM_END_ITER(stats, iter) (stats).endIter(iter)
+#else
+#define IPM_TIME_PHASE(stats, phase, bytes)
+#define IPM_END_ITER(stats, iter)
+#endif
+
+#endif
@@ -1,11 +1,14 @@
 #ifndef IPM_CONST_H
 #define IPM_CONST_H
 
+#include <string>
+
 enum OptionNla {
   kOptionNlaMin = 0,
   kOptionNlaAugmented = kOptionNlaMin,
   kOptionNlaNormEq,
-  kOptionNlaMax = kOptionNlaNormEq,
+  kOptionNlaChoose,
+  kOptionNlaMax = kOptionNlaChoose,
   kOptionNlaDefault = kOptionNlaNormEq
 };
 
@@ -27,10 +30,71 @@ enum kOptionCrossover {
   kOptionCrossoverDefault = kOptionCrossoverOff
 };
 
+enum OptionDenseCols {
+  kOptionDenseColsMin = 0,
+  kOptionDenseColsOff = kOptionDenseColsMin,
+  kOptionDenseColsOn,
+  kOptionDenseColsMax = kOptionDenseColsOn,
+  kOptionDenseColsDefault = kOptionDenseColsOff
+};
+
+enum OptionDiagnostics {
+  kOptionDiagnosticsMin = 0,
+  kOptionDiagnosticsOff = kOptionDiagnosticsMin,
+  kOptionDiagnosticsSampled,
+  kOptionDiagnosticsOn,
+  kOptionDiagnosticsMax = kOptionDiagnosticsOn,
+  kOptionDiagnosticsDefault = kOptionDiagnosticsOff
+};
+
+enum OptionScaling {
+  kOptionScalingMin = 0,
+  kOptionScalingNone = kOptionScalingMin,
+  kOptionScalingCR,
+  kOptionScalingGeometric,
+  kOptionScalingRuiz,
+  kOptionScalingMax = kOptionScalingRuiz,
+  kOptionScalingDefault = kOptionScalingCR
+};
+
+enum OptionScaleObj {
+  kOptionScaleObjMin = 0,
+  kOptionScaleObjOff = kOptionScaleObjMin,
+  kOptionScaleObjOn,
+  kOptionScaleObjMax = kOptionScaleObjOn,
+  kOptionScaleObjDefault = kOptionScaleObjOff
+};
+
+enum OptionCorrectors {
+  kOptionCorrectorsMin = 0,
+  kOptionCorrectorsStatic = kOptionCorrectorsMin,
+  kOptionCorrectorsAdaptive,
+  kOptionCorrectorsMax = kOptionCorrectorsAdaptive,
+  kOptionCorrectorsDefault = kOptionCorrectorsStatic
+};
+
+enum OptionRefine {
+  kOptionRefineMin = 0,
+  kOptionRefineOff = kOptionRefineMin,
+  kOptionRefineClassic,
+  kOptionRefineKrylov,
+  kOptionRefineMax = kOptionRefineKrylov,
+  kOptionRefineDefault = kOptionRefineOff
+};
+
 struct Options {
   int nla = kOptionNlaDefault;
   int format = kOptionFormatDefault;
   int crossover = kOptionCrossoverOff;
+  int dense_cols = kOptionDenseColsDefault;
+  int diagnostics = kOptionDiagnosticsDefault;
+  int scaling = kOptionScalingDefault;
+  int scale_obj = kOptionScaleObjDefault;
+  int correctors = kOptionCorrectorsDefault;
+  int refine = kOptionRefineDefault;
+
+  // file where the iterations are logged as JSON lines, empty to disable it
+  std::string log_file{};
 };
 
 enum IpmStatus {
@@ -64,6 +128,57 @@ const double kMccIncreaseMin = 0.1;
 const double kSmallProduct = 1e-3;
 const double kLargeProduct = 1e3;
 
+// The factorisation uses BLAS-3 and runs in parallel, the solves use BLAS-2
+// and run serially. To compare their efforts, the flops of the factorisation
+// are multiplied by kFactoriseEffortWeight, estimated empirically.
+const double kFactoriseEffortWeight = 1.0 / 112.0;
+
+// with adaptive correctors, the number of correctors is re-tuned from the
+// times measured after the first kAdaptiveCorrectorsWarmup iterations. The
+// measurements are averaged with weight kAdaptiveCorrectorsWeight given to
+// the last iteration.
+const int kAdaptiveCorrectorsWarmup = 1;
+const double kAdaptiveCorrectorsWeight = 0.3;
+
+// maximum number of passes over the data to find the best corrector weights
+const int kMaxWeightIter = 10;
+
+// ratio tests over the variables are split into chunks of kStepChunkSize
+// components, processed in parallel if there are at least kParallelStepMin
+// components. The chunks do not depend on the number of threads.
+const int kStepChunkSize = 8192;
+const int kParallelStepMin = 65536;
+
+// parameters for dense columns of the normal equations
+const double kDenseColRatio = 10.0;
+const double kDenseColFraction = 0.1;
+const int kMaxDenseCols = 50;
+
+// with sampled diagnostics, the backward error is computed every
+// kDiagnosticsFrequency iterations
+const int kDiagnosticsFrequency = 5;
+
+// iterative refinement stops when the normwise backward error is below
+// kRefinementTolerance, or when a step does not reduce it at least by a factor
+// kRefinementStagnation. At most kMaxRefinementIter steps are performed.
+const double kRefinementTolerance = 1e-12;
+const double kRefinementStagnation = 0.5;
+
+// number of records reserved in the buffers of the iteration log
+const int kIterLogReserve = 1024;
+
+// warm start: each complementary variable of the previous solution is raised
+// to at least sqrt(mu), so that the products are at least mu, and the products
+// are then reduced to at most mu / kWarmStartCentre, with mu at least
+// kWarmStartMu
+const double kWarmStartMu = 1e-2;
+const double kWarmStartCentre = 0.1;
+
+// parameters of the scaling methods
+const int kGeomScalingIter = 8;
+const int kRuizScalingIter = 20;
+const double kRuizScalingTol = 1e-2;
+
 // other parameters
 const double kInteriorScaling = 0.999;
 
@@ -0,0 +1,133 @@
+#include "IterationLog.h"
+
+#include <cmath>
+
+#include "Ipm_const.h"
+
+std::string jsonEscape(const std::string& str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (char ch : str) {
+    if (ch == '"' || ch == '\\') {
+      escaped += '\\';
+      escaped += ch;
+    } else if ((unsigned char)ch < 0x20) {
+      char code[8];
+      snprintf(code, sizeof(code), "\\u%04x", (unsigned char)ch);
+      escaped += code;
+    } else {
+      escaped += ch;
+    }
+  }
+  return escaped;
+}
+
+IterationLog::~IterationLog() { close(); }
+
+bool IterationLog::open(const std::string& file_name,
+                        const std::string& pb_name) {
+  close();
+
+  file_ = fopen(file_name.c_str(), "a");
+  if (!file_) return false;
+
+  pb_name_ = jsonEscape(pb_name);
+  stop_ = false;
+
+  // space for many iterations, so that push does not allocate
+  pending_.reserve(kIterLogReserve);
+  writing_.reserve(kIterLogReserve);
+
+  writer_ = std::thread(&IterationLog::run, this);
+  return true;
+}
+
+void IterationLog::push(const IterLogRecord& rec) {
+  if (!file_) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(rec);
+  }
+  cv_.notify_one();
+}
+
+void IterationLog::close() {
+  if (!file_) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  writer_.join();
+
+  fclose(file_);
+  file_ = nullptr;
+}
+
+void IterationLog::run() {
+  while (true) {
+    bool stop;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+      pending_.swap(writing_);
+      stop = stop_;
+    }
+
+    for (const IterLogRecord& rec : writing_) write(rec);
+    writing_.clear();
+    fflush(file_);
+
+    if (stop) break;
+  }
+}
+
+// write "key":value, using null for values that are not finite, which JSON
+// cannot represent
+static void writeField(FILE* file, const char* key, double value) {
+  if (std::isfinite(value))
+    fprintf(file, ",\"%s\":%.10g", key, value);
+  else
+    fprintf(file, ",\"%s\":null", key);
+}
+
+void IterationLog::write(const IterLogRecord& r) const {
+  fprintf(file_, "{\"model\":\"%s\",\"iter\":%d,\"correctors\":%d",
+          pb_name_.c_str(), r.iter, r.correctors);
+  writeField(file_, "p_obj", r.p_obj);
+  writeField(file_, "d_obj", r.d_obj);
+  writeField(file_, "p_inf", r.p_inf);
+  writeField(file_, "d_inf", r.d_inf);
+  writeField(file_, "mu", r.mu);
+  writeField(file_, "pd_gap", r.pd_gap);
+  writeField(file_, "p_alpha", r.p_alpha);
+  writeField(file_, "d_alpha", r.d_alpha);
+  writeField(file_, "sigma_aff", r.sigma_aff);
+  writeField(file_, "sigma", r.sigma);
+  writeField(file_, "min_xl", r.min_xl);
+  writeField(file_, "max_xl", r.max_xl);
+  writeField(file_, "min_xu", r.min_xu);
+  writeField(file_, "max_xu", r.max_xu);
+  writeField(file_, "min_zl", r.min_zl);
+  writeField(file_, "max_zl", r.max_zl);
+  writeField(file_, "min_zu", r.min_zu);
+  writeField(file_, "max_zu", r.max_zu);
+  writeField(file_, "min_dxl", r.min_dxl);
+  writeField(file_, "max_dxl", r.max_dxl);
+  writeField(file_, "min_dxu", r.min_dxu);
+  writeField(file_, "max_dxu", r.max_dxu);
+  writeField(file_, "min_dzl", r.min_dzl);
+  writeField(file_, "max_dzl", r.max_dzl);
+  writeField(file_, "min_dzu", r.min_dzu);
+  writeField(file_, "max_dzu", r.max_dzu);
+  writeField(file_, "min_theta", r.min_theta);
+  writeField(file_, "max_theta", r.max_theta);
+  writeField(file_, "min_prod", r.min_prod);
+  writeField(file_, "max_prod", r.max_prod);
+  fprintf(file_, ",\"num_small_prod\":%d,\"num_large_prod\":%d",
+          r.num_small_prod, r.num_large_prod);
+  writeField(file_, "time", r.time);
+  writeField(file_, "factorise_time", r.factorise_time);
+  writeField(file_, "solve_time", r.solve_time);
+  fprintf(file_, "}\n");
+}
@@ -0,0 +1,70 @@
+#ifndef ITERATION_LOG_H
+#define ITERATION_LOG_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Data of a single ipm iteration, as gathered by collectData, together with
+// the time spent in the iteration.
+struct IterLogRecord {
+  int iter;
+  int correctors;
+  double p_obj, d_obj, p_inf, d_inf, mu, pd_gap;
+  double p_alpha, d_alpha, sigma_aff, sigma;
+  double min_xl, max_xl, min_xu, max_xu, min_zl, max_zl, min_zu, max_zu;
+  double min_dxl, max_dxl, min_dxu, max_dxu, min_dzl, max_dzl, min_dzu,
+      max_dzu;
+  double min_theta, max_theta, min_prod, max_prod;
+  int num_small_prod, num_large_prod;
+  double time, factorise_time, solve_time;
+};
+
+// Escape a string to be written between quotes in JSON
+std::string jsonEscape(const std::string& str);
+
+// Asynchronous log of the ipm iterations, written as JSON lines, one object
+// per iteration, appended to a file.
+//
+// The solver only copies the record into a buffer, under a mutex. A separate
+// thread swaps the buffer with a second one, formats the records and writes
+// them, so that the solver never waits for the file.
+class IterationLog {
+  FILE* file_ = nullptr;
+
+  // name of the problem, already escaped for JSON
+  std::string pb_name_{};
+
+  // records pushed by the solver, and records being written
+  std::vector<IterLogRecord> pending_{};
+  std::vector<IterLogRecord> writing_{};
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  std::thread writer_;
+
+  void run();
+  void write(const IterLogRecord& rec) const;
+
+ public:
+  IterationLog() = default;
+  ~IterationLog();
+  IterationLog(const IterationLog&) = delete;
+  IterationLog& operator=(const IterationLog&) = delete;
+
+  // Open the file and start the writer. Return false if the file cannot be
+  // opened.
+  bool open(const std::string& file_name, const std::string& pb_name);
+
+  // Queue a record to be written
+  void push(const IterLogRecord& rec);
+
+  // Write all the records queued and stop the writer
+  void close();
+};
+
+#endif
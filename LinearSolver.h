@@ -17,11 +17,15 @@
 // - clear: reset the data structure for the next factorization.
 //
 // The linear solver may also define functions:
-// - setup: perform any preliminary calculation (e.g. symbolic factorization)
-// - refine: apply iterative refinement to the solution
+// - setup: perform any preliminary calculation (e.g. symbolic factorization).
+//   If options.nla is kOptionNlaChoose, setup decides which system to use and
+//   stores the choice in options.nla.
+// - refineAS, refineNE: apply iterative refinement to the solution of the
+//   augmented system or normal equations
 // - finalise: perform any final action
 // - flops: return number of flops needed for factorisation
 // - nz: return number of nonzeros in factorisation
+// - numDenseCols: return number of dense columns treated separately
 //
 // NB: forming the normal equations or augmented system is delegated to the
 // linear solver chosen, so that only the appropriate data (upper triangle,
@@ -65,21 +69,32 @@ class LinearSolver {
   // Virtual functions.
   // These may be overridden by derived classes, if needed.
   // =================================================================
-  virtual int setup(const HighsSparseMatrix& A, const Options& options) {
+  virtual int setup(const HighsSparseMatrix& A, Options& options) {
     return 0;
   }
 
-  virtual void refine(const HighsSparseMatrix& A,
-                      const std::vector<double>& scaling,
-                      const std::vector<double>& rhs_x,
-                      const std::vector<double>& rhs_y,
-                      std::vector<double>& lhs_x, std::vector<double>& lhs_y) {}
+  virtual int refineAS(const HighsSparseMatrix& A,
+                       const std::vector<double>& scaling,
+                       const std::vector<double>& rhs_x,
+                       const std::vector<double>& rhs_y,
+                       std::vector<double>& lhs_x,
+                       std::vector<double>& lhs_y) {
+    return 0;
+  }
+
+  virtual int refineNE(const HighsSparseMatrix& A,
+                       const std::vector<double>& scaling,
+                       const std::vector<double>& rhs,
+                       std::vector<double>& lhs) {
+    return 0;
+  }
 
   virtual void finalise() {}
 
   virtual double flops() const { return 0; }
   virtual double spops() const { return 0; }
   virtual double nz() const { return 0; }
+  virtual int numDenseCols() const { return 0; }
 };
 
 #endif
\ No newline at end of file
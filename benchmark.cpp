@@ -0,0 +1,420 @@
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "Highs.h"
+#include "Ipm.h"
+#include "IterationLog.h"
+#include "io/Filereader.h"
+#include "ipm/IpxWrapper.h"
+#include "parallel/HighsParallel.h"
+
+// Benchmark harness.
+//
+// Solves the models listed in a manifest, each in a separate process, and
+// writes the results in CSV or JSON format. Each line of the manifest
+// contains the path of a model followed, optionally, by options given as
+// key=value pairs, e.g. "afiro.mps nla=1 scaling=2". The keys are the names
+// of the integer fields of Options. Empty lines and lines starting with # are
+// ignored.
+//
+// With -j jobs > 1, several models run at the same time and the threads are
+// shared among them; with -j 1, each model uses the whole thread pool. Each
+// model is solved -r times, to estimate the variability of the times.
+//
+// Every run is a child process, so that crashes do not stop the benchmark and
+// the peak memory of each run can be measured with wait4. The child sends its
+// results to the parent through a pipe.
+
+// results of a single run, sent by the child to the parent
+struct RunResult {
+  int status;
+  int iter;
+  double read_time;
+  double presolve_time;
+  double setup_time;
+  double load_time;
+  double analyse_time;
+  double factorise_time;
+  double solve_time;
+  double ipm_time;
+  double optimize_time;
+  double nz;
+  double flops;
+};
+
+struct ManifestEntry {
+  std::string file;
+  Options options;
+};
+
+struct Run {
+  int entry;
+  int repeat;
+  pid_t pid;
+  int fd;
+  bool ok;
+  double peak_rss;
+  RunResult result;
+};
+
+static void usage() {
+  std::cerr << "======= How to use: ./test manifest [-j jobs] [-r repeats] "
+               "[-f csv|json] [-o output] [-v] =======\n";
+  std::cerr << "manifest : one model per line, optionally followed by "
+               "key=value options\n";
+  std::cerr << "           keys: nla format crossover dense_cols "
+               "diagnostics scaling scale_obj correctors refine\n";
+  std::cerr << "-j jobs  : number of models solved at the same time\n";
+  std::cerr << "-r repeat: number of runs of each model\n";
+  std::cerr << "-f format: format of the results\n";
+  std::cerr << "-o output: file of the results, default stdout\n";
+  std::cerr << "-v       : keep the output of the solver\n";
+}
+
+// set the option given as key=value. Return false if the key is unknown or
+// the value is not a legal integer for it.
+static bool setOption(const std::string& pair, Options& options) {
+  struct OptionEntry {
+    const char* key;
+    int* value;
+    int min;
+    int max;
+  };
+  const OptionEntry table[] = {
+      {"nla", &options.nla, kOptionNlaMin, kOptionNlaMax},
+      {"format", &options.format, kOptionFormatMin, kOptionFormatMax},
+      {"crossover", &options.crossover, kOptionCrossoverMin,
+       kOptionCrossoverMax},
+      {"dense_cols", &options.dense_cols, kOptionDenseColsMin,
+       kOptionDenseColsMax},
+      {"diagnostics", &options.diagnostics, kOptionDiagnosticsMin,
+       kOptionDiagnosticsMax},
+      {"scaling", &options.scaling, kOptionScalingMin, kOptionScalingMax},
+      {"scale_obj", &options.scale_obj, kOptionScaleObjMin,
+       kOptionScaleObjMax},
+      {"correctors", &options.correctors, kOptionCorrectorsMin,
+       kOptionCorrectorsMax},
+      {"refine", &options.refine, kOptionRefineMin, kOptionRefineMax}};
+
+  size_t eq = pair.find('=');
+  if (eq == std::string::npos) return false;
+  std::string key = pair.substr(0, eq);
+  std::string value = pair.substr(eq + 1);
+
+  for (const OptionEntry& opt : table) {
+    if (key != opt.key) continue;
+    char* end;
+    long v = strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || v < opt.min || v > opt.max)
+      return false;
+    *opt.value = v;
+    return true;
+  }
+  return false;
+}
+
+static bool readManifest(const std::string& name,
+                         std::vector<ManifestEntry>& entries) {
+  std::ifstream manifest(name);
+  if (!manifest) return false;
+
+  std::string line;
+  int line_num = 0;
+  while (getline(manifest, line)) {
+    ++line_num;
+    std::stringstream ss(line);
+    ManifestEntry entry;
+    if (!(ss >> entry.file) || entry.file[0] == '#') continue;
+
+    // optional options, as key=value
+    std::string pair;
+    while (ss >> pair) {
+      if (!setOption(pair, entry.options)) {
+        std::cerr << "Illegal option " << pair << " in line " << line_num
+                  << " of " << name << "\n";
+        return false;
+      }
+    }
+
+    entries.push_back(entry);
+  }
+  return true;
+}
+
+static RunResult solveModel(const ManifestEntry& entry) {
+  RunResult res{};
+  Clock clock;
+
+  // read and presolve
+  Highs highs;
+  highs.setOptionValue("output_flag", false);
+  HighsStatus status = highs.readModel(entry.file);
+  res.read_time = clock.stop();
+  if (status != HighsStatus::kOk) {
+    res.status = kIpmStatusError;
+    return res;
+  }
+
+  clock.start();
+  status = highs.presolve();
+  res.presolve_time = clock.stop();
+  if (status != HighsStatus::kOk) {
+    res.status = kIpmStatusError;
+    return res;
+  }
+
+  // change formulation
+  clock.start();
+  int n, m;
+  std::vector<double> obj, rhs, lower, upper, Aval;
+  std::vector<int> Aptr, Aind;
+  std::vector<char> constraints;
+  double offset;
+  const HighsLp& lp = highs.getPresolvedLp();
+  Ipm::reserveForSlacks(lp.num_col_, lp.num_row_, lp.a_matrix_.numNz(), obj,
+                        lower, upper, Aptr, Aind, Aval);
+  fillInIpxData(lp, n, m, offset, obj, lower, upper, Aptr, Aind, Aval, rhs,
+                constraints);
+  highs.clear();
+  res.setup_time = clock.stop();
+
+  // load and solve
+  clock.start();
+  Ipm ipm{};
+  ipm.load(n, m, std::move(obj), std::move(rhs), std::move(lower),
+           std::move(upper), std::move(Aptr), std::move(Aind), std::move(Aval),
+           std::move(constraints), offset, extractModelName(entry.file),
+           entry.options);
+  res.load_time = clock.stop();
+
+  clock.start();
+  res.status = ipm.solve();
+  res.optimize_time = clock.stop();
+
+  res.iter = ipm.getIter();
+  res.analyse_time = ipm.getAnalyseTime();
+  res.factorise_time = ipm.getFactoriseTime();
+  res.solve_time = ipm.getSolveTime();
+  res.ipm_time = ipm.getIpmTime();
+  res.nz = ipm.getNz();
+  res.flops = ipm.getFlops();
+
+  return res;
+}
+
+static bool launch(Run& run, const ManifestEntry& entry, int threads,
+                   bool verbose) {
+  int fds[2];
+  if (pipe(fds)) return false;
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+
+  if (pid == 0) {
+    // child: solve the model and send the results to the parent
+    close(fds[0]);
+    if (!verbose) {
+      int null_fd = open("/dev/null", O_WRONLY);
+      dup2(null_fd, STDOUT_FILENO);
+      close(null_fd);
+    }
+
+    highs::parallel::initialize_scheduler(threads);
+    RunResult res = solveModel(entry);
+
+    bool ok = write(fds[1], &res, sizeof(res)) == sizeof(res);
+    close(fds[1]);
+    _exit(ok ? 0 : 1);
+  }
+
+  // parent
+  close(fds[1]);
+  run.pid = pid;
+  run.fd = fds[0];
+  return true;
+}
+
+static const char* statusString(int status) {
+  switch (status) {
+    case kIpmStatusError:
+      return "Error";
+    case kIpmStatusMaxIter:
+      return "Max iter";
+    case kIpmStatusNoProgress:
+      return "No progress";
+    case kIpmStatusPDFeas:
+      return "PD feas";
+    case kIpmStatusBasic:
+      return "Basic";
+    default:
+      return "Unknown";
+  }
+}
+
+static void writeCsv(FILE* out, const std::vector<ManifestEntry>& entries,
+                     const std::vector<Run>& runs) {
+  fprintf(out,
+          "model,repeat,status,iter,read,presolve,setup,load,analyse,"
+          "factorise,solve,ipm,optimize,peak_rss,nz,flops\n");
+  for (const Run& run : runs) {
+    const RunResult& r = run.result;
+    fprintf(out, "%s,%d,%s,%d,", entries[run.entry].file.c_str(), run.repeat,
+            run.ok ? statusString(r.status) : "Crash", r.iter);
+    fprintf(out, "%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,", r.read_time,
+            r.presolve_time, r.setup_time, r.load_time, r.analyse_time,
+            r.factorise_time, r.solve_time, r.ipm_time, r.optimize_time);
+    fprintf(out, "%.0f,%.0f,%.6e\n", run.peak_rss, r.nz, r.flops);
+  }
+}
+
+static void writeJson(FILE* out, const std::vector<ManifestEntry>& entries,
+                      const std::vector<Run>& runs) {
+  fprintf(out, "[\n");
+  for (size_t i = 0; i < runs.size(); ++i) {
+    const Run& run = runs[i];
+    const RunResult& r = run.result;
+    fprintf(out, "  {\"model\": \"%s\", \"repeat\": %d, \"status\": \"%s\", ",
+            jsonEscape(entries[run.entry].file).c_str(), run.repeat,
+            run.ok ? statusString(r.status) : "Crash");
+    fprintf(out, "\"iter\": %d, \"read\": %.4f, \"presolve\": %.4f, ", r.iter,
+            r.read_time, r.presolve_time);
+    fprintf(out, "\"setup\": %.4f, \"load\": %.4f, \"analyse\": %.4f, ",
+            r.setup_time, r.load_time, r.analyse_time);
+    fprintf(out, "\"factorise\": %.4f, \"solve\": %.4f, \"ipm\": %.4f, ",
+            r.factorise_time, r.solve_time, r.ipm_time);
+    fprintf(out, "\"optimize\": %.4f, \"peak_rss\": %.0f, ", r.optimize_time,
+            run.peak_rss);
+    fprintf(out, "\"nz\": %.0f, \"flops\": %.6e}%s\n", r.nz, r.flops,
+            i + 1 < runs.size() ? "," : "");
+  }
+  fprintf(out, "]\n");
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    usage();
+    return 1;
+  }
+
+  std::string manifest = argv[1];
+  int jobs = 1;
+  int repeats = 1;
+  bool json = false;
+  bool verbose = false;
+  std::string output{};
+
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-v") {
+      verbose = true;
+    } else if (i + 1 < argc && arg == "-j") {
+      jobs = atoi(argv[++i]);
+    } else if (i + 1 < argc && arg == "-r") {
+      repeats = atoi(argv[++i]);
+    } else if (i + 1 < argc && arg == "-f") {
+      json = std::string(argv[++i]) == "json";
+    } else if (i + 1 < argc && arg == "-o") {
+      output = argv[++i];
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if (jobs < 1 || repeats < 1) {
+    usage();
+    return 1;
+  }
+
+  std::vector<ManifestEntry> entries;
+  if (!readManifest(manifest, entries)) {
+    std::cerr << "Error reading manifest " << manifest << "\n";
+    return 1;
+  }
+
+  // threads available to each model
+  int hardware_threads = std::thread::hardware_concurrency();
+  int threads = std::max(1, hardware_threads / jobs);
+
+  // runs are ordered by repeat, so that repeats of the same model are not
+  // executed at the same time
+  std::vector<Run> runs;
+  for (int rep = 0; rep < repeats; ++rep)
+    for (int e = 0; e < (int)entries.size(); ++e)
+      runs.push_back({e, rep, -1, -1, false, 0.0, RunResult{}});
+
+  Clock clock;
+  int next = 0;
+  int running = 0;
+  int done = 0;
+  while (done < (int)runs.size()) {
+    // start new runs, up to the number of jobs
+    while (running < jobs && next < (int)runs.size()) {
+      Run& run = runs[next++];
+      if (launch(run, entries[run.entry], threads, verbose)) {
+        ++running;
+      } else {
+        std::cerr << "Error starting run of " << entries[run.entry].file
+                  << "\n";
+        ++done;
+      }
+    }
+
+    // wait for any run to finish
+    int wstatus;
+    struct rusage ru;
+    pid_t pid = wait4(-1, &wstatus, 0, &ru);
+    if (pid < 0) break;
+
+    for (Run& run : runs) {
+      if (run.pid != pid) continue;
+
+      run.ok = read(run.fd, &run.result, sizeof(run.result)) ==
+                   sizeof(run.result) &&
+               WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0;
+      close(run.fd);
+
+      // ru_maxrss is in kilobytes on Linux and in bytes on macOS
+#ifdef __APPLE__
+      run.peak_rss = ru.ru_maxrss;
+#else
+      run.peak_rss = ru.ru_maxrss * 1024.0;
+#endif
+
+      std::cerr << "[" << done + 1 << "/" << runs.size() << "] "
+                << entries[run.entry].file << ": "
+                << (run.ok ? statusString(run.result.status) : "Crash")
+                << "\n";
+      break;
+    }
+    --running;
+    ++done;
+  }
+
+  FILE* out = output.empty() ? stdout : fopen(output.c_str(), "w");
+  if (!out) {
+    std::cerr << "Error opening " << output << "\n";
+    return 1;
+  }
+  json ? writeJson(out, entries, runs) : writeCsv(out, entries, runs);
+  if (out != stdout) fclose(out);
+
+  std::cerr << "Time: " << clock.stop() << '\n';
+
+  return 0;
+}
@@ -1,4 +1,6 @@
 #include <cassert>
+#include <climits>
+#include <cstdlib>
 #include <cstring>  // For strchr
 #include <iostream>
 #include <regex>
@@ -16,72 +18,125 @@ enum ArgC {
   kOptionNlaArg,
   kOptionFormat,
   kOptionCrossover,
+  kOptionDenseCols,
+  kOptionDiagnostics,
+  kOptionScaling,
+  kOptionScaleObj,
+  kSnapshotArg,
+  kLogFileArg,
+  kOptionCorrectors,
+  kOptionRefine,
   kMaxArgC
 };
 
+// Convert an integer option. Anything that is not an integer, e.g. a path
+// passed in the wrong position, gives -1, which fails the range check of
+// every option.
+static int parseOption(const char* arg) {
+  char* end;
+  long value = strtol(arg, &end, 10);
+  if (end == arg || *end != '\0' || value < 0 || value > INT_MAX) return -1;
+  return value;
+}
+
 int main(int argc, char** argv) {
   if (argc < kMinArgC || argc > kMaxArgC) {
     std::cerr << "======= How to use: ./ipm LP_name.mps(.gz) nla_option "
-                 "format_option crossover_option =======\n";
-    std::cerr << "nla_option       : 0 aug sys, 1 norm eq\n";
+                 "format_option crossover_option dense_cols_option "
+                 "diagnostics_option scaling_option scale_obj_option "
+                 "snapshot_file log_file correctors_option refine_option "
+                 "=======\n";
+    std::cerr << "nla_option       : 0 aug sys, 1 norm eq, 2 choose\n";
     std::cerr << "format_option    : 0 full, 1 hybrid packed, 2 hybrid hybrid, "
                  "3 packed packed\n";
     std::cerr << "crossover_option : 0 off, 1 on\n";
+    std::cerr << "dense_cols_option: 0 off, 1 on\n";
+    std::cerr << "diagnostics_option: 0 off, 1 sampled, 2 on\n";
+    std::cerr << "scaling_option   : 0 none, 1 Curtis-Reid, 2 geometric, "
+                 "3 Ruiz\n";
+    std::cerr << "scale_obj_option : 0 off, 1 on\n";
+    std::cerr << "snapshot_file    : file where the loaded model is saved, "
+                 "to be read back as LP_name.ipm\n";
+    std::cerr << "log_file         : file where the iterations are logged "
+                 "as JSON lines\n";
+    std::cerr << "correctors_option: 0 static, 1 adaptive\n";
+    std::cerr << "refine_option    : 0 off, 1 classic, 2 Krylov\n";
     return 1;
   }
 
   Clock clock0;
   Clock clock;
 
-  // ===================================================================================
-  // READ PROBLEM
-  // ===================================================================================
-
-  // Read LP using Highs MPS read
-  Highs highs;
-  //  highs.setOptionValue("output_flag", false);
   std::string model_file = argv[kModelFileArg];
   std::string model = extractModelName(model_file);
-  HighsStatus status = highs.readModel(model_file);
-  assert(status == HighsStatus::kOk);
-  double read_time = clock.stop();
-  const bool presolve = true;
-  HighsLp lp;
-  double presolve_time = -1;
-  if (presolve) {
-    clock.start();
-    status = highs.presolve();
-    assert(status == HighsStatus::kOk);
-    lp = highs.getPresolvedLp();
-    presolve_time = clock.stop();
-  } else {
-    lp = highs.getLp();
-    presolve_time = 0;
-  }
 
-  // ===================================================================================
-  // CHANGE FORMULATION
-  // ===================================================================================
-  // Input problem must be in the form
-  //
-  //  min   obj^T * x
-  //  s.t.  A * x {<=,=,>=} rhs
-  //        lower <= x <= upper
-  //
-  //  constraints[i] is : =, <, >
-  // ===================================================================================
+  // a file with extension .ipm is a snapshot of a model already presolved,
+  // reformulated and scaled, which is loaded directly into ipm
+  const std::string snapshot_ext = ".ipm";
+  const bool from_snapshot =
+      model_file.size() > snapshot_ext.size() &&
+      model_file.compare(model_file.size() - snapshot_ext.size(),
+                         snapshot_ext.size(), snapshot_ext) == 0;
 
-  clock.start();
   int n, m;
   std::vector<double> obj, rhs, lower, upper, Aval;
   std::vector<int> Aptr, Aind;
   std::vector<char> constraints;
   double offset;
 
-  fillInIpxData(lp, n, m, offset, obj, lower, upper, Aptr, Aind, Aval, rhs,
-                constraints);
+  double read_time = 0;
+  double presolve_time = 0;
+  double setup_time = 0;
+
+  if (!from_snapshot) {
+    // ===================================================================================
+    // READ PROBLEM
+    // ===================================================================================
+
+    // Read LP using Highs MPS read
+    Highs highs;
+    //  highs.setOptionValue("output_flag", false);
+    HighsStatus status = highs.readModel(model_file);
+    assert(status == HighsStatus::kOk);
+    read_time = clock.stop();
+    const bool presolve = true;
+    if (presolve) {
+      clock.start();
+      status = highs.presolve();
+      assert(status == HighsStatus::kOk);
+      presolve_time = clock.stop();
+    }
+
+    // refer to the lp stored in highs, without copying it
+    const HighsLp& lp = presolve ? highs.getPresolvedLp() : highs.getLp();
+
+    // ===================================================================================
+    // CHANGE FORMULATION
+    // ===================================================================================
+    // Input problem must be in the form
+    //
+    //  min   obj^T * x
+    //  s.t.  A * x {<=,=,>=} rhs
+    //        lower <= x <= upper
+    //
+    //  constraints[i] is : =, <, >
+    // ===================================================================================
 
-  double setup_time = clock.stop();
+    clock.start();
+
+    // reserve space for the slacks added when loading the model, at most one
+    // per row, so that ipm can adopt the vectors without reallocating them
+    Ipm::reserveForSlacks(lp.num_col_, lp.num_row_, lp.a_matrix_.numNz(), obj,
+                          lower, upper, Aptr, Aind, Aval);
+
+    fillInIpxData(lp, n, m, offset, obj, lower, upper, Aptr, Aind, Aval, rhs,
+                  constraints);
+
+    // the data is now in the vectors above, free the copies kept by highs
+    highs.clear();
+
+    setup_time = clock.stop();
+  }
 
   // ===================================================================================
   // IDENTIFY OPTIONS
@@ -90,8 +145,8 @@ int main(int argc, char** argv) {
   Options options{};
 
   // option to choose normal equations or augmented system
-  options.nla =
-      argc > kOptionNlaArg ? atoi(argv[kOptionNlaArg]) : kOptionNlaDefault;
+  options.nla = argc > kOptionNlaArg ? parseOption(argv[kOptionNlaArg])
+                                     : kOptionNlaDefault;
   if (options.nla < kOptionNlaMin || options.nla > kOptionNlaMax) {
     std::cerr << "Illegal value of " << options.nla
               << " for option_nla: must be in [" << kOptionNlaMin << ", "
@@ -100,8 +155,8 @@ int main(int argc, char** argv) {
   }
 
   // option to choose storage format inside FactorHiGHS
-  options.format =
-      argc > kOptionFormat ? atoi(argv[kOptionFormat]) : kOptionFormatDefault;
+  options.format = argc > kOptionFormat ? parseOption(argv[kOptionFormat])
+                                        : kOptionFormatDefault;
   if (options.format < kOptionFormatMin || options.format > kOptionFormatMax) {
     std::cerr << "Illegal value of " << options.format
               << " for option_format: must be in [" << kOptionFormatMin << ", "
@@ -110,8 +165,9 @@ int main(int argc, char** argv) {
   }
 
   // option to choose crossover
-  options.crossover = argc > kOptionCrossover ? atoi(argv[kOptionCrossover])
-                                              : kOptionCrossoverDefault;
+  options.crossover = argc > kOptionCrossover
+                          ? parseOption(argv[kOptionCrossover])
+                          : kOptionCrossoverDefault;
   if (options.crossover < kOptionCrossoverMin ||
       options.crossover > kOptionCrossoverMax) {
     std::cerr << "Illegal value of " << options.crossover
@@ -120,6 +176,83 @@ int main(int argc, char** argv) {
     return 1;
   }
 
+  // option to treat dense columns separately in the normal equations
+  options.dense_cols = argc > kOptionDenseCols
+                           ? parseOption(argv[kOptionDenseCols])
+                           : kOptionDenseColsDefault;
+  if (options.dense_cols < kOptionDenseColsMin ||
+      options.dense_cols > kOptionDenseColsMax) {
+    std::cerr << "Illegal value of " << options.dense_cols
+              << " for option_dense_cols: must be in [" << kOptionDenseColsMin
+              << ", " << kOptionDenseColsMax << "]\n";
+    return 1;
+  }
+
+  // option to compute the backward error of the Newton directions
+  options.diagnostics = argc > kOptionDiagnostics
+                            ? parseOption(argv[kOptionDiagnostics])
+                            : kOptionDiagnosticsDefault;
+  if (options.diagnostics < kOptionDiagnosticsMin ||
+      options.diagnostics > kOptionDiagnosticsMax) {
+    std::cerr << "Illegal value of " << options.diagnostics
+              << " for option_diagnostics: must be in ["
+              << kOptionDiagnosticsMin << ", " << kOptionDiagnosticsMax
+              << "]\n";
+    return 1;
+  }
+
+  // scaling of the matrix
+  options.scaling = argc > kOptionScaling ? parseOption(argv[kOptionScaling])
+                                          : kOptionScalingDefault;
+  if (options.scaling < kOptionScalingMin ||
+      options.scaling > kOptionScalingMax) {
+    std::cerr << "Illegal value of " << options.scaling
+              << " for option_scaling: must be in [" << kOptionScalingMin
+              << ", " << kOptionScalingMax << "]\n";
+    return 1;
+  }
+
+  // scaling of objective and bounds
+  options.scale_obj = argc > kOptionScaleObj
+                          ? parseOption(argv[kOptionScaleObj])
+                          : kOptionScaleObjDefault;
+  if (options.scale_obj < kOptionScaleObjMin ||
+      options.scale_obj > kOptionScaleObjMax) {
+    std::cerr << "Illegal value of " << options.scale_obj
+              << " for option_scale_obj: must be in [" << kOptionScaleObjMin
+              << ", " << kOptionScaleObjMax << "]\n";
+    return 1;
+  }
+
+  // option to adapt the number of correctors to the measured times
+  options.correctors = argc > kOptionCorrectors
+                           ? parseOption(argv[kOptionCorrectors])
+                           : kOptionCorrectorsDefault;
+  if (options.correctors < kOptionCorrectorsMin ||
+      options.correctors > kOptionCorrectorsMax) {
+    std::cerr << "Illegal value of " << options.correctors
+              << " for option_correctors: must be in ["
+              << kOptionCorrectorsMin << ", " << kOptionCorrectorsMax << "]\n";
+    return 1;
+  }
+
+  // option to refine the solution of the Newton system
+  options.refine = argc > kOptionRefine ? parseOption(argv[kOptionRefine])
+                                        : kOptionRefineDefault;
+  if (options.refine < kOptionRefineMin || options.refine > kOptionRefineMax) {
+    std::cerr << "Illegal value of " << options.refine
+              << " for option_refine: must be in [" << kOptionRefineMin << ", "
+              << kOptionRefineMax << "]\n";
+    return 1;
+  }
+
+  // file where the snapshot of the model is written
+  std::string snapshot_file{};
+  if (argc > kSnapshotArg) snapshot_file = argv[kSnapshotArg];
+
+  // file where the iterations are logged
+  if (argc > kLogFileArg) options.log_file = argv[kLogFileArg];
+
   // extract problem name witout mps from path
   std::string pb_name{};
   std::regex rgx("([^/]+)\\.(mps|lp)");
@@ -139,10 +272,21 @@ int main(int argc, char** argv) {
   // HighsTaskExecutor::shutdown(true);
   highs::parallel::initialize_scheduler();
 
-  // load the problem
-  ipm.load(n, m, obj.data(), rhs.data(), lower.data(), upper.data(),
-           Aptr.data(), Aind.data(), Aval.data(), constraints.data(), offset,
-           pb_name, options);
+  // load the problem, moving the data into ipm
+  if (from_snapshot) {
+    if (!ipm.loadSnapshot(model_file, options)) {
+      std::cerr << "Error reading snapshot " << model_file << "\n";
+      return 1;
+    }
+  } else {
+    ipm.load(n, m, std::move(obj), std::move(rhs), std::move(lower),
+             std::move(upper), std::move(Aptr), std::move(Aind),
+             std::move(Aval), std::move(constraints), offset, pb_name,
+             options);
+  }
+
+  if (!snapshot_file.empty() && !ipm.writeSnapshot(snapshot_file))
+    std::cerr << "Error writing snapshot " << snapshot_file << "\n";
   double load_time = clock.stop();
 
   // solve LP